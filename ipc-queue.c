@@ -8,6 +8,171 @@
 /* magic number to indicate the queue integrity */
 #define IPC_QUEUE_SENTINEL 0x474E495246435049ULL
 
+/* ring layout flags are encoded in the sentinel low byte */
+#define IPC_QUEUE_SENTINEL_FLAGS_MASK (IPC_QUEUE_POW2 | IPC_QUEUE_PADDED)
+
+/* padded layout cache line size is encoded in the sentinel second byte */
+#define IPC_QUEUE_SENTINEL_LINE_SHIFT 8u
+
+/* element format set by queue user is encoded in the sentinel third byte */
+#define IPC_QUEUE_SENTINEL_FORMAT_SHIFT 16u
+
+/* message header size marking that next message starts at ring start */
+#define IPC_QUEUE_MSG_WRAP 0xFFFFFFFFu
+
+/**
+ * struct ipc_queue_msg_hdr - variable length message header
+ * @size:	message payload size in bytes or IPC_QUEUE_MSG_WRAP
+ * @reserved:	reserved, keeps payload aligned to ring element size
+ */
+struct ipc_queue_msg_hdr {
+	uint32_t size;
+	uint32_t reserved;
+};
+
+/**
+ * ipc_queue_map_ring() - get references to the fields of a mapped ring
+ * @queue:	[IN] queue pointer (flags already initialized)
+ * @ring:	[OUT] ring field references
+ * @addr:	[IN] ring address in shared memory
+ */
+static void ipc_queue_map_ring(const struct ipc_queue *queue,
+		struct ipc_ring_ref *ring, uintptr_t addr)
+{
+	struct ipc_ring *ring_legacy;
+	struct ipc_ring_padded *ring_padded;
+
+	if ((queue->flags & IPC_QUEUE_PADDED) != 0u) {
+		ring_padded = (struct ipc_ring_padded *) addr;
+		ring->sentinel = &ring_padded->sentinel;
+		ring->write = &ring_padded->write;
+		ring->read = &ring_padded->read;
+		ring->data = ring_padded->data;
+	} else {
+		ring_legacy = (struct ipc_ring *) addr;
+		ring->sentinel = &ring_legacy->sentinel;
+		ring->write = &ring_legacy->write;
+		ring->read = &ring_legacy->read;
+		ring->data = ring_legacy->data;
+	}
+}
+
+/**
+ * ipc_queue_peek() - get the element at the head of the queue in place
+ * @queue:	[IN] queue pointer
+ *
+ * Element stays in the pop ring (remote shared memory) and can be read in
+ * place until it is removed with ipc_queue_consume().
+ *
+ * Return:	pointer to element in pop ring, NULL if queue is empty
+ */
+const void *ipc_queue_peek(struct ipc_queue *queue)
+{
+	uint32_t read; /* cache read index for thread-safety */
+
+	if (queue == NULL) {
+		return NULL;
+	}
+
+	/* read indexes of push/pop rings are swapped (interference freedom) */
+	read = *queue->push.read;
+
+	/* check if queue is empty */
+	if (ipc_queue_pop_avail(queue, read, 1u) == 0u) {
+		return NULL;
+	}
+
+	return &queue->pop.data[ipc_queue_slot(queue, read)
+		* queue->elem_size];
+}
+
+/**
+ * ipc_queue_consume() - remove the element at the head of the queue
+ * @queue:	[IN] queue pointer
+ *
+ * Used after ipc_queue_peek() once the element is no longer accessed: the
+ * element slot is returned to remote and may be overwritten.
+ *
+ * Return:	0 on success, error code otherwise
+ */
+int ipc_queue_consume(struct ipc_queue *queue)
+{
+	uint32_t read; /* cache read index for thread-safety */
+
+	if (queue == NULL) {
+		return -EINVAL;
+	}
+
+	read = *queue->push.read;
+
+	/* element was seen by peek, shadow index already covers it */
+	if (ipc_queue_pop_avail(queue, read, 1u) == 0u) {
+		return -ENOBUFS;
+	}
+
+	/* increment read index with wrap around, after element is read */
+	ipc_os_store_release(queue->push.read,
+		ipc_queue_advance(queue, read, 1u));
+
+	return 0;
+}
+
+/**
+ * ipc_queue_reserve() - get the next free element of the queue in place
+ * @queue:	[IN] queue pointer
+ *
+ * Element is located in the push ring (local shared memory) and can be written
+ * in place. It becomes visible to remote only after ipc_queue_commit().
+ *
+ * Return:	pointer to element in push ring, NULL if queue is full
+ */
+void *ipc_queue_reserve(struct ipc_queue *queue)
+{
+	uint32_t write; /* cache write index for thread-safety */
+
+	if (queue == NULL) {
+		return NULL;
+	}
+
+	write = *queue->push.write;
+
+	/* check if queue is full */
+	if (ipc_queue_push_room(queue, write, 1u) == 0u) {
+		return NULL;
+	}
+
+	return &queue->push.data[ipc_queue_slot(queue, write)
+		* queue->elem_size];
+}
+
+/**
+ * ipc_queue_commit() - push the element obtained with ipc_queue_reserve()
+ * @queue:	[IN] queue pointer
+ *
+ * Return:	0 on success, error code otherwise
+ */
+int ipc_queue_commit(struct ipc_queue *queue)
+{
+	uint32_t write; /* cache write index for thread-safety */
+
+	if (queue == NULL) {
+		return -EINVAL;
+	}
+
+	write = *queue->push.write;
+
+	/* element was reserved, shadow index already covers it */
+	if (ipc_queue_push_room(queue, write, 1u) == 0u) {
+		return -ENOMEM;
+	}
+
+	/* increment write index with wrap around, after element is written */
+	ipc_os_store_release(queue->push.write,
+		ipc_queue_advance(queue, write, 1u));
+
+	return 0;
+}
+
 /**
  * ipc_queue_pop() - removes element from queue
  * @queue:	[IN] queue pointer
@@ -20,32 +185,21 @@
  */
 int ipc_queue_pop(struct ipc_queue *queue, void *buf)
 {
-	uint32_t write; /* cache write index for thread-safety */
-	uint32_t read; /* cache read index for thread-safety */
-	void *src;
+	const void *src;
 
 	if ((queue == NULL) || (buf == NULL)) {
 		return -EINVAL;
 	}
 
-	write = queue->pop_ring->write;
-
-	/* read indexes of push/pop rings are swapped (interference freedom) */
-	read = queue->push_ring->read;
-
-	/* check if queue is empty */
-	if (read == write) {
+	src = ipc_queue_peek(queue);
+	if (src == NULL) {
 		return -ENOBUFS;
 	}
 
 	/* copy queue element in buffer */
-	src = &queue->pop_ring->data[read * queue->elem_size];
 	(void) memcpy(buf, src, queue->elem_size);
 
-	/* increment read index with wrap around */
-	queue->push_ring->read = (read + 1u) % queue->elem_num;
-
-	return 0;
+	return ipc_queue_consume(queue);
 }
 
 /**
@@ -60,30 +214,452 @@ int ipc_queue_pop(struct ipc_queue *queue, void *buf)
  */
 int ipc_queue_push(struct ipc_queue *queue, const void *buf)
 {
-	uint32_t write; /* cache write index for thread-safety */
-	uint32_t read; /* cache read index for thread-safety */
 	void *dst;
 
 	if ((queue == NULL) || (buf == NULL)) {
 		return -EINVAL;
 	}
 
-	write = queue->push_ring->write;
+	dst = ipc_queue_reserve(queue);
+	if (dst == NULL) {
+		return -ENOMEM;
+	}
+
+	/* copy element from buffer in queue */
+	(void) memcpy(dst, buf, queue->elem_size);
+
+	return ipc_queue_commit(queue);
+}
+
+/**
+ * ipc_queue_pop_n() - removes up to n elements from queue
+ * @queue:	[IN] queue pointer
+ * @buf:	[OUT] pointer where to copy the removed elements
+ * @n:		[IN] maximum number of elements to remove
+ *
+ * Elements are removed from pop ring in FIFO order and copied contiguously in
+ * buf. The read index is published only once, after all elements are copied,
+ * so a burst costs a single index write in shared memory.
+ *
+ * Return:	number of elements removed (0 if queue is empty), error code
+ *		otherwise
+ */
+int ipc_queue_pop_n(struct ipc_queue *queue, void *buf, uint32_t n)
+{
+	uint32_t read; /* cache read index for thread-safety */
+	uint32_t count, chunk, slot;
+	uint8_t *dst = (uint8_t *)buf;
+
+	if ((queue == NULL) || (buf == NULL)) {
+		return -EINVAL;
+	}
 
 	/* read indexes of push/pop rings are swapped (interference freedom) */
-	read = queue->pop_ring->read;
+	read = *queue->push.read;
+
+	/* number of elements available in queue, limited to n */
+	count = ipc_queue_pop_avail(queue, read, n);
+	if (count > n) {
+		count = n;
+	}
+	if (count == 0u) {
+		return 0;
+	}
+
+	/* copy elements in at most two chunks (before and after wrap around) */
+	slot = ipc_queue_slot(queue, read);
+	chunk = queue->elem_num - slot;
+	if (chunk > count) {
+		chunk = count;
+	}
+	(void) memcpy(dst, &queue->pop.data[slot * queue->elem_size],
+		chunk * queue->elem_size);
+	if (chunk < count) {
+		(void) memcpy(&dst[chunk * queue->elem_size],
+			&queue->pop.data[0],
+			(count - chunk) * queue->elem_size);
+	}
+
+	/* publish read index once for the entire burst */
+	ipc_os_store_release(queue->push.read,
+		ipc_queue_advance(queue, read, count));
+
+	return (int)count;
+}
+
+/**
+ * ipc_queue_push_n() - pushes up to n elements into the queue
+ * @queue:	[IN] queue pointer
+ * @buf:	[IN] pointer to contiguous elements to be pushed into the queue
+ * @n:		[IN] number of elements in buf
+ *
+ * Elements are pushed into the push ring in FIFO order. If there is not enough
+ * room for all n elements, only the leading elements that fit are pushed. The
+ * write index is published only once, after all elements are copied, so the
+ * remote sees the entire burst at the same time.
+ *
+ * Return:	number of elements pushed (0 if queue is full), error code
+ *		otherwise
+ */
+int ipc_queue_push_n(struct ipc_queue *queue, const void *buf, uint32_t n)
+{
+	uint32_t write; /* cache write index for thread-safety */
+	uint32_t count, chunk, slot;
+	const uint8_t *src = (const uint8_t *)buf;
+
+	if ((queue == NULL) || (buf == NULL)) {
+		return -EINVAL;
+	}
+
+	write = *queue->push.write;
+
+	/* free room in queue, limited to n */
+	count = ipc_queue_push_room(queue, write, n);
+	if (count > n) {
+		count = n;
+	}
+	if (count == 0u) {
+		return 0;
+	}
+
+	/* copy elements in at most two chunks (before and after wrap around) */
+	slot = ipc_queue_slot(queue, write);
+	chunk = queue->elem_num - slot;
+	if (chunk > count) {
+		chunk = count;
+	}
+	(void) memcpy(&queue->push.data[slot * queue->elem_size], src,
+		chunk * queue->elem_size);
+	if (chunk < count) {
+		(void) memcpy(&queue->push.data[0],
+			&src[chunk * queue->elem_size],
+			(count - chunk) * queue->elem_size);
+	}
+
+	/* publish write index once for the entire burst */
+	ipc_os_store_release(queue->push.write,
+		ipc_queue_advance(queue, write, count));
+
+	return (int)count;
+}
+
+/**
+ * ipc_queue_push64_mp() - multi-producer push of an 8 byte element
+ * @queue:	[IN] queue pointer (initialized with 8 byte elements)
+ * @elem:	[IN] element to be pushed into the queue
+ *
+ * The producer claims a push ticket if the ring has room for one element
+ * more than the tickets claimed but not yet published, then waits for the
+ * previous tickets to be published and publishes its element. Only the
+ * ticket owner accesses the push ring write index, so the ring is written in
+ * order by a single thread at a time. The Rx handler is kept off the CPU
+ * from claim to publish (ipc_os_ticket_enter()), so that Rx callbacks can use
+ * the same queue.
+ *
+ * Return:	0 on success, -ENOMEM if queue is full
+ */
+int ipc_queue_push64_mp(struct ipc_queue *queue, uint64_t elem)
+{
+	uint32_t ticket, done, write, room;
+
+	/* a ticket holder must not be preempted by a waiter on the same CPU */
+	ipc_os_ticket_enter();
+	do {
+		/* tickets are loaded before write index: pending tickets
+		 * already published are counted twice, never missed
+		 */
+		done = ipc_os_load_acquire(&queue->push_done);
+		ticket = ipc_os_load_acquire(&queue->push_claim);
+		write = ipc_os_load_acquire(queue->push.write);
+		room = ipc_queue_room(queue, write,
+			ipc_os_load_acquire(queue->pop.read));
+
+		if (room <= (ticket - done)) {
+			ipc_os_ticket_exit();
+			return -ENOMEM;
+		}
+	} while (!ipc_os_cas(&queue->push_claim, ticket, ticket + 1u));
 
-	/* check if queue is full ([write + 1 == read] because of sentinel) */
-	if (((write + 1u) % queue->elem_num) == read) {
+	/* publish in ticket order */
+	while (ipc_os_load_acquire(&queue->push_done) != ticket) {
+		ipc_os_cpu_relax();
+	}
+
+	write = *queue->push.write;
+	((uint64_t *)queue->push.data)[ipc_queue_slot(queue, write)] = elem;
+
+	/* increment write index with wrap around, after element is written */
+	ipc_os_store_release(queue->push.write,
+		ipc_queue_advance(queue, write, 1u));
+
+	/* hand over the push ring to next ticket */
+	ipc_os_store_release(&queue->push_done, ticket + 1u);
+	ipc_os_ticket_exit();
+
+	return 0;
+}
+
+/**
+ * ipc_queue_pop64_mc() - multi-consumer pop of an 8 byte element
+ * @queue:	[IN] queue pointer (initialized with 8 byte elements)
+ * @elem:	[OUT] removed element
+ *
+ * Counterpart of ipc_queue_push64_mp() for consumers: a pop ticket is claimed
+ * if the ring holds one element more than the tickets claimed but not yet
+ * published, and elements are removed in ticket order.
+ *
+ * Return:	0 on success, -ENOBUFS if queue is empty
+ */
+int ipc_queue_pop64_mc(struct ipc_queue *queue, uint64_t *elem)
+{
+	uint32_t ticket, done, read, avail;
+
+	ipc_os_ticket_enter();
+	do {
+		done = ipc_os_load_acquire(&queue->pop_done);
+		ticket = ipc_os_load_acquire(&queue->pop_claim);
+		read = ipc_os_load_acquire(queue->push.read);
+		avail = ipc_queue_used(queue,
+			ipc_os_load_acquire(queue->pop.write), read);
+
+		if (avail <= (ticket - done)) {
+			ipc_os_ticket_exit();
+			return -ENOBUFS;
+		}
+	} while (!ipc_os_cas(&queue->pop_claim, ticket, ticket + 1u));
+
+	/* remove in ticket order */
+	while (ipc_os_load_acquire(&queue->pop_done) != ticket) {
+		ipc_os_cpu_relax();
+	}
+
+	/* read indexes of push/pop rings are swapped (interference freedom) */
+	read = *queue->push.read;
+	*elem = ((const uint64_t *)queue->pop.data)[ipc_queue_slot(queue, read)];
+
+	/* increment read index with wrap around, after element is read */
+	ipc_os_store_release(queue->push.read,
+		ipc_queue_advance(queue, read, 1u));
+
+	/* hand over the pop ring to next ticket */
+	ipc_os_store_release(&queue->pop_done, ticket + 1u);
+	ipc_os_ticket_exit();
+
+	return 0;
+}
+
+/**
+ * ipc_queue_msg_elems() - number of ring elements occupied by a message
+ * @size:	[IN] message payload size in bytes
+ */
+static inline uint32_t ipc_queue_msg_elems(uint32_t size)
+{
+	/* header element + payload rounded up to whole elements */
+	return 1u + ((size + IPC_QUEUE_MSG_ELEM_SIZE - 1u)
+		/ IPC_QUEUE_MSG_ELEM_SIZE);
+}
+
+/**
+ * ipc_queue_msg_max_size() - max payload size of a variable length message
+ * @queue:	[IN] queue pointer
+ *
+ * Messages are never split at the end of the ring, so a message must be at
+ * most half of the ring to always fit in, regardless of the ring position.
+ *
+ * Return:	max payload size in bytes, 0 if queue can't carry messages
+ */
+uint32_t ipc_queue_msg_max_size(const struct ipc_queue *queue)
+{
+	uint32_t usable = queue->elem_num;
+
+	/* one element is kept as sentinel (except power-of-two mode) */
+	if ((queue->flags & IPC_QUEUE_POW2) == 0u) {
+		usable--;
+	}
+
+	if ((queue->elem_size != IPC_QUEUE_MSG_ELEM_SIZE) || (usable < 4u)) {
+		return 0;
+	}
+
+	return ((usable / 2u) - 1u) * IPC_QUEUE_MSG_ELEM_SIZE;
+}
+
+/**
+ * ipc_queue_msg_push() - pushes a variable length message into the queue
+ * @queue:	[IN] queue pointer
+ * @buf:	[IN] message payload
+ * @size:	[IN] message payload size in bytes
+ *
+ * The message is copied in contiguous ring elements, after a header element
+ * containing the payload size. If the message doesn't fit before the end of
+ * the ring, the remaining elements are skipped using a wrap header and the
+ * message is copied at the ring start. Header and payload are published with
+ * a single write index update.
+ *
+ * Only aligned stores are done in the ring: the last partial payload word is
+ * padded before being copied.
+ *
+ * Return:	0 on success, error code otherwise
+ */
+int ipc_queue_msg_push(struct ipc_queue *queue, const void *buf, uint32_t size)
+{
+	uint32_t write; /* cache write index for thread-safety */
+	uint32_t slot, need, skip, aligned;
+	struct ipc_queue_msg_hdr *hdr;
+	const uint8_t *src = (const uint8_t *)buf;
+	uint8_t *dst;
+	uint64_t last = 0;
+
+	if ((queue == NULL) || ((buf == NULL) && (size != 0u))
+			|| (size > ipc_queue_msg_max_size(queue))) {
+		return -EINVAL;
+	}
+
+	need = ipc_queue_msg_elems(size);
+	write = *queue->push.write;
+	slot = ipc_queue_slot(queue, write);
+
+	/* skip the ring end if message doesn't fit before it */
+	skip = queue->elem_num - slot;
+	if (skip >= need) {
+		skip = 0;
+	}
+
+	if (ipc_queue_push_room(queue, write, skip + need) < (skip + need)) {
 		return -ENOMEM;
 	}
 
-	/* copy element from buffer in queue */
-	dst = &queue->push_ring->data[write * queue->elem_size];
-	(void) memcpy(dst, buf, queue->elem_size);
+	if (skip != 0u) {
+		hdr = (struct ipc_queue_msg_hdr *)
+			&queue->push.data[slot * IPC_QUEUE_MSG_ELEM_SIZE];
+		hdr->size = IPC_QUEUE_MSG_WRAP;
+		hdr->reserved = 0;
+		slot = 0;
+	}
+
+	hdr = (struct ipc_queue_msg_hdr *)
+		&queue->push.data[slot * IPC_QUEUE_MSG_ELEM_SIZE];
+	hdr->size = size;
+	hdr->reserved = 0;
+
+	/* copy payload words, last partial word padded (aligned stores) */
+	dst = (uint8_t *)&hdr[1];
+	aligned = size & ~(IPC_QUEUE_MSG_ELEM_SIZE - 1u);
+	(void) memcpy(dst, src, aligned);
+	if (aligned != size) {
+		(void) memcpy(&last, &src[aligned], size - aligned);
+		(void) memcpy(&dst[aligned], &last, sizeof(last));
+	}
+
+	/* publish wrap header, message header and payload at once */
+	ipc_os_store_release(queue->push.write,
+		ipc_queue_advance(queue, write, skip + need));
+
+	return 0;
+}
+
+/**
+ * ipc_queue_msg_peek() - get the message at the head of the queue in place
+ * @queue:	[IN] queue pointer
+ * @buf:	[OUT] message payload in pop ring
+ * @size:	[OUT] message payload size in bytes
+ *
+ * Message stays in the pop ring (remote shared memory) and can be read in
+ * place until it is removed with ipc_queue_msg_consume(). Ring elements
+ * skipped by remote with a wrap header are consumed.
+ *
+ * Return:	0 on success, -ENOBUFS if queue is empty, error code otherwise
+ */
+int ipc_queue_msg_peek(struct ipc_queue *queue, const void **buf,
+		uint32_t *size)
+{
+	uint32_t read; /* cache read index for thread-safety */
+	uint32_t slot, skip, need;
+	const struct ipc_queue_msg_hdr *hdr;
+
+	if ((queue == NULL) || (buf == NULL) || (size == NULL)) {
+		return -EINVAL;
+	}
+
+	/* read indexes of push/pop rings are swapped (interference freedom) */
+	read = *queue->push.read;
+
+	if (ipc_queue_pop_avail(queue, read, 1u) == 0u) {
+		return -ENOBUFS;
+	}
+
+	slot = ipc_queue_slot(queue, read);
+	hdr = (const struct ipc_queue_msg_hdr *)
+		&queue->pop.data[slot * IPC_QUEUE_MSG_ELEM_SIZE];
 
-	/* increment write index with wrap around */
-	queue->push_ring->write = (write + 1u) % queue->elem_num;
+	/* consume skipped ring end and continue from ring start */
+	if (hdr->size == IPC_QUEUE_MSG_WRAP) {
+		skip = queue->elem_num - slot;
+		if (ipc_queue_pop_avail(queue, read, skip + 1u)
+				< (skip + 1u)) {
+			return -EINVAL;
+		}
+
+		read = ipc_queue_advance(queue, read, skip);
+		ipc_os_store_release(queue->push.read, read);
+
+		hdr = (const struct ipc_queue_msg_hdr *)&queue->pop.data[0];
+	}
+
+	/* message is published at once, so it must be entirely available */
+	need = ipc_queue_msg_elems(hdr->size);
+	if ((hdr->size > ipc_queue_msg_max_size(queue))
+			|| (ipc_queue_pop_avail(queue, read, need) < need)) {
+		return -EINVAL;
+	}
+
+	*buf = &hdr[1];
+	*size = hdr->size;
+
+	return 0;
+}
+
+/**
+ * ipc_queue_msg_consume() - remove the message at the head of the queue
+ * @queue:	[IN] queue pointer
+ *
+ * Used after ipc_queue_msg_peek() once the message is no longer accessed.
+ *
+ * Return:	0 on success, error code otherwise
+ */
+int ipc_queue_msg_consume(struct ipc_queue *queue)
+{
+	uint32_t read; /* cache read index for thread-safety */
+	uint32_t need;
+	const struct ipc_queue_msg_hdr *hdr;
+
+	if (queue == NULL) {
+		return -EINVAL;
+	}
+
+	read = *queue->push.read;
+
+	if (ipc_queue_pop_avail(queue, read, 1u) == 0u) {
+		return -ENOBUFS;
+	}
+
+	hdr = (const struct ipc_queue_msg_hdr *)
+		&queue->pop.data[ipc_queue_slot(queue, read)
+			* IPC_QUEUE_MSG_ELEM_SIZE];
+
+	/* wrap header is consumed by peek */
+	if (hdr->size == IPC_QUEUE_MSG_WRAP) {
+		return -EINVAL;
+	}
+
+	need = ipc_queue_msg_elems(hdr->size);
+	if (ipc_queue_pop_avail(queue, read, need) < need) {
+		return -EINVAL;
+	}
+
+	/* increment read index with wrap around, after message is read */
+	ipc_os_store_release(queue->push.read,
+		ipc_queue_advance(queue, read, need));
 
 	return 0;
 }
@@ -93,58 +669,153 @@ int ipc_queue_push(struct ipc_queue *queue, const void *buf)
  * @queue:		[IN] queue pointer
  * @elem_num:		[IN] number of elements in queue
  * @elem_size:		[IN] element size in bytes (8-byte multiple)
+ * @flags:		[IN] ring layout flags (IPC_QUEUE_*)
  * @push_ring_addr:	[IN] local addr where to map the push buffer ring
  * @pop_ring_addr:	[IN] remote addr where to map the pop buffer ring
  *
  * Element size must be 8-byte multiple to ensure memory alignment.
  *
  * Queue will add one additional sentinel element to its size for lock-free
- * single-producer - single-consumer thread-safety.
+ * single-producer - single-consumer thread-safety. In power-of-two mode
+ * (IPC_QUEUE_POW2) the ring size is instead rounded up to a power of two and
+ * the write/read indexes are free-running counters wrapped with a mask.
+ *
+ * In padded mode (IPC_QUEUE_PADDED) the sentinel, the write index, the read
+ * index and the ring data each start on their own cache line, so the rings
+ * should be mapped at cache line aligned addresses.
+ *
+ * The ring layout flags are stored in the ring sentinel, so a remote using a
+ * different layout for the complementary queue fails the integrity check.
  *
  * Return: 0 on success, error code otherwise
  */
 int ipc_queue_init(struct ipc_queue *queue,
-		   uint16_t elem_num, uint8_t elem_size,
+		   uint16_t elem_num, uint8_t elem_size, uint8_t flags,
 		   uintptr_t push_ring_addr, uintptr_t pop_ring_addr)
 {
+	uint32_t ring_size = 1u;
+
 	if ((queue == NULL) || (push_ring_addr == (uintptr_t)NULL) ||
 		(pop_ring_addr == (uintptr_t)NULL) || (elem_num == 0u) ||
 		(elem_size == 0u) || ((elem_size % 8u) != 0u)) {
 		return -EINVAL;
 	}
 
-	/* add 1 sentinel element in queue for lock-free thread-safety */
-	queue->elem_num = elem_num + 1u;
+	queue->flags = flags;
+
+	if ((flags & IPC_QUEUE_POW2) != 0u) {
+		/* round ring size up to a power of two */
+		while (ring_size < elem_num) {
+			ring_size <<= 1;
+		}
+		queue->elem_num = ring_size;
+		queue->mask = ring_size - 1u;
+	} else {
+		/* add 1 sentinel element in queue for lock-free thread-safety */
+		queue->elem_num = (uint32_t)elem_num + 1u;
+		queue->mask = 0u;
+	}
 
 	queue->elem_size = elem_size;
 
+	/* sentinel identifies both ring integrity and ring layout */
+	queue->sentinel = IPC_QUEUE_SENTINEL
+		^ ((uint64_t)flags & IPC_QUEUE_SENTINEL_FLAGS_MASK);
+	if ((flags & IPC_QUEUE_PADDED) != 0u) {
+		queue->sentinel ^= (uint64_t)IPC_QUEUE_CACHE_LINE_SIZE
+			<< IPC_QUEUE_SENTINEL_LINE_SHIFT;
+	}
+
 	/* map and init push ring in local memory */
-	queue->push_ring = (struct ipc_ring *) push_ring_addr;
+	ipc_queue_map_ring(queue, &queue->push, push_ring_addr);
 
 	/* add sentinel to detect integrity */
-	queue->push_ring->sentinel = IPC_QUEUE_SENTINEL;
+	*queue->push.sentinel = queue->sentinel;
+
+	*queue->push.write = 0;
+	*queue->push.read = 0;
 
-	queue->push_ring->write = 0;
-	queue->push_ring->read = 0;
+	/* remote indexes start from 0 as well (remote init) */
+	queue->remote_write = 0;
+	queue->remote_read = 0;
+
+	queue->push_claim = 0;
+	queue->push_done = 0;
+	queue->pop_claim = 0;
+	queue->pop_done = 0;
 
 	/* map pop ring in remote memory (init is done by remote) */
-	queue->pop_ring = (struct ipc_ring *) pop_ring_addr;
+	ipc_queue_map_ring(queue, &queue->pop, pop_ring_addr);
 
 	return 0;
 }
 
+/**
+ * ipc_queue_set_format() - tag queue sentinel with element format
+ * @queue:	[IN] queue pointer
+ * @format:	[IN] element format identifier defined by queue user
+ *
+ * Called right after ipc_queue_init(), before remote checks queue integrity.
+ * The format is stored in the ring sentinel, so a remote using a different
+ * element format for the complementary queue fails the integrity check.
+ */
+void ipc_queue_set_format(struct ipc_queue *queue, uint8_t format)
+{
+	queue->sentinel ^= (uint64_t)format << IPC_QUEUE_SENTINEL_FORMAT_SHIFT;
+	*queue->push.sentinel = queue->sentinel;
+}
+
+/**
+ * ipc_queue_count() - number of elements that can be popped from queue
+ * @queue:	[IN] queue pointer
+ *
+ * Indexes are loaded from shared memory, shadow copies are not used nor
+ * updated, so the function can be called from any thread. The result is a
+ * snapshot: remote may push more elements at any time.
+ *
+ * Return:	number of elements in pop ring
+ */
+uint32_t ipc_queue_count(struct ipc_queue *queue)
+{
+	return ipc_queue_used(queue, ipc_os_load_acquire(queue->pop.write),
+		ipc_os_load_acquire(queue->push.read));
+}
+
+/**
+ * ipc_queue_space() - number of elements that can be pushed into queue
+ * @queue:	[IN] queue pointer
+ *
+ * Indexes are loaded from shared memory, shadow copies are not used nor
+ * updated, so the function can be called from any thread. Elements claimed
+ * but not yet published by local producers (IPC_QUEUE_MP) are not free. The
+ * result is a snapshot: remote may pop more elements at any time.
+ *
+ * Return:	number of free elements in push ring
+ */
+uint32_t ipc_queue_space(struct ipc_queue *queue)
+{
+	uint32_t done = ipc_os_load_acquire(&queue->push_done);
+	uint32_t pending = ipc_os_load_acquire(&queue->push_claim) - done;
+	uint32_t room = ipc_queue_room(queue,
+		ipc_os_load_acquire(queue->push.write),
+		ipc_os_load_acquire(queue->pop.read));
+
+	return (room > pending) ? (room - pending) : 0u;
+}
+
 /**
  * ipc_queue_check_integrity() - check if the sentinel was not overwritten
  * @queue:	[IN] queue pointer
  *
- * Check if the sentinel was not overwritten
+ * Check if the sentinel was not overwritten and that the remote uses the same
+ * ring layout.
  *
  * Return:	0 on success, error code otherwise
  */
 int ipc_queue_check_integrity(struct ipc_queue *queue)
 {
-	if ((IPC_QUEUE_SENTINEL == queue->pop_ring->sentinel) &&
-			(IPC_QUEUE_SENTINEL == queue->push_ring->sentinel))
+	if ((queue->sentinel == *queue->pop.sentinel) &&
+			(queue->sentinel == *queue->push.sentinel))
 		return 0;
 
 	return -EINVAL;
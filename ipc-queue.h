@@ -5,6 +5,41 @@
 #ifndef IPC_QUEUE_H
 #define IPC_QUEUE_H
 
+/*
+ * Ring layout flags, must be identical for local and remote queue:
+ * IPC_QUEUE_POW2:	ring size rounded up to a power of two, free-running
+ *			write/read indexes wrapped with a mask
+ * IPC_QUEUE_PADDED:	sentinel, write index, read index and ring data placed
+ *			on separate cache lines of IPC_QUEUE_CACHE_LINE_SIZE
+ */
+#define IPC_QUEUE_POW2		0x01u
+#define IPC_QUEUE_PADDED	0x02u
+
+/*
+ * Local threading flags, don't change the ring layout:
+ * IPC_QUEUE_MP:	multiple local threads can push 8 byte elements
+ * IPC_QUEUE_MC:	multiple local threads can pop 8 byte elements
+ */
+#define IPC_QUEUE_MP		0x04u
+#define IPC_QUEUE_MC		0x08u
+
+/*
+ * Cache line size used by padded ring layout
+ */
+#ifndef IPC_QUEUE_CACHE_LINE_SIZE
+#define IPC_QUEUE_CACHE_LINE_SIZE 64u
+#endif
+
+/*
+ * Element size of queues carrying variable length messages
+ */
+#define IPC_QUEUE_MSG_ELEM_SIZE 8u
+
+/* round size up to a multiple of cache line size */
+#define IPC_QUEUE_ALIGN(size) \
+	((((size) + IPC_QUEUE_CACHE_LINE_SIZE - 1u) \
+		/ IPC_QUEUE_CACHE_LINE_SIZE) * IPC_QUEUE_CACHE_LINE_SIZE)
+
 /**
  * struct ipc_ring - memory mapped circular buffer ring
  * @sentinel: a magic word to ensure ring integrity
@@ -14,17 +49,64 @@
  */
 struct ipc_ring {
 	uint64_t sentinel;
-	volatile uint32_t write;
-	volatile uint32_t read;
+	uint32_t write;
+	uint32_t read;
 	uint8_t data[];
 };
 
+/**
+ * struct ipc_ring_padded - memory mapped circular buffer ring, padded layout
+ * @sentinel: a magic word to ensure ring integrity
+ * @write:	write index, position used to store next byte in the buffer
+ * @read:	read index, read next byte from this position
+ * @data:	circular buffer
+ *
+ * Each field starts on its own cache line, so that the write index updated by
+ * the producer, the read index updated by the consumer and the first ring
+ * elements are not falsely shared when shared memory is mapped cacheable.
+ */
+struct ipc_ring_padded {
+	uint64_t sentinel;
+	uint8_t pad0[IPC_QUEUE_CACHE_LINE_SIZE - sizeof(uint64_t)];
+	uint32_t write;
+	uint8_t pad1[IPC_QUEUE_CACHE_LINE_SIZE - sizeof(uint32_t)];
+	uint32_t read;
+	uint8_t pad2[IPC_QUEUE_CACHE_LINE_SIZE - sizeof(uint32_t)];
+	uint8_t data[];
+};
+
+/**
+ * struct ipc_ring_ref - references to the fields of a mapped ring
+ * @sentinel:	ring sentinel
+ * @write:	ring write index
+ * @read:	ring read index
+ * @data:	ring circular buffer
+ *
+ * Resolved once at queue init for the ring layout in use, so that push/pop
+ * operations don't depend on the layout.
+ */
+struct ipc_ring_ref {
+	uint64_t *sentinel;
+	uint32_t *write;
+	uint32_t *read;
+	uint8_t *data;
+};
+
 /**
  * struct ipc_queue - Dual-Ring Shared-Memory Lock-Free FIFO Queue
- * @elem_num:	number of elements in queue
+ * @elem_num:	number of elements in ring
  * @elem_size:  element size in bytes (8-byte multiple)
- * @push_ring:	push buffer ring mapped in local shared memory
- * @pop_ring:	pop buffer ring mapped in remote shared memory
+ * @flags:	ring layout flags (IPC_QUEUE_*)
+ * @mask:	ring index mask (power-of-two mode only)
+ * @sentinel:	expected sentinel of push/pop rings (encodes layout flags)
+ * @push:	push buffer ring mapped in local shared memory
+ * @pop:	pop buffer ring mapped in remote shared memory
+ * @remote_write:	shadow copy of pop ring write index (used by consumer)
+ * @remote_read:	shadow copy of pop ring read index (used by producer)
+ * @push_claim:	push tickets claimed by local producers (IPC_QUEUE_MP)
+ * @push_done:	push tickets published by local producers (IPC_QUEUE_MP)
+ * @pop_claim:	pop tickets claimed by local consumers (IPC_QUEUE_MC)
+ * @pop_done:	pop tickets published by local consumers (IPC_QUEUE_MC)
  *
  * This queue has two buffer rings one for pushing data and one for popping
  * data and works in conjunction with a complementary queue configured by
@@ -41,19 +123,85 @@ struct ipc_ring {
  * thread is popping: Single-Producer - Single-Consumer. This thread safety
  * is lock-free and needs one additional sentinel element in rings between
  * write and read index that is never written.
+ *
+ * Write and read indexes are published with release semantics and remote
+ * indexes are loaded with acquire semantics, so ring elements are never
+ * observed before the index update that covers them. This makes the queue
+ * safe on shared memory mapped as normal (cacheable) memory as well.
+ *
+ * Elements can also be accessed in place, without an intermediate copy: the
+ * producer writes the slot returned by ipc_queue_reserve() and publishes it
+ * with ipc_queue_commit(), the consumer reads the slot returned by
+ * ipc_queue_peek() and frees it with ipc_queue_consume().
+ *
+ * Both indexes read from remote memory are cached locally in a shadow copy that
+ * is refreshed only when it shows the queue full (push) or empty (pop), so
+ * under steady load push/pop operations don't access remote memory.
+ *
+ * In power-of-two mode the write and read indexes are free-running counters
+ * and the ring slot is obtained by masking, so no division is needed on the
+ * push/pop path and no sentinel element is needed to tell full from empty.
+ *
+ * In multi-producer (IPC_QUEUE_MP) or multi-consumer (IPC_QUEUE_MC) mode,
+ * ipc_queue_push64()/ipc_queue_pop64() can be called concurrently by several
+ * local threads: each thread claims a ticket with a compare and swap on a
+ * local counter, after checking that the elements claimed before it leave
+ * room for one more, and then publishes its element in ticket order. The
+ * rings are updated one element at a time, as in SPSC mode, so remote needs
+ * no change. A thread preempted between claim and publish delays the threads
+ * that claimed after it.
  */
 struct ipc_queue {
 	uint8_t elem_size;
-	uint16_t elem_num;
-	struct ipc_ring *push_ring;
-	struct ipc_ring *pop_ring;
+	uint8_t flags;
+	uint32_t elem_num;
+	uint32_t mask;
+	uint64_t sentinel;
+	struct ipc_ring_ref push;
+	struct ipc_ring_ref pop;
+	uint32_t remote_write;
+	uint32_t remote_read;
+	uint32_t push_claim;
+	uint32_t push_done;
+	uint32_t pop_claim;
+	uint32_t pop_done;
 };
 
 int ipc_queue_init(struct ipc_queue *queue, uint16_t elem_num,
-	uint8_t elem_size, uintptr_t push_ring_addr, uintptr_t pop_ring_addr);
+	uint8_t elem_size, uint8_t flags, uintptr_t push_ring_addr,
+	uintptr_t pop_ring_addr);
+void ipc_queue_set_format(struct ipc_queue *queue, uint8_t format);
+
+/*
+ * Generic element operations. Driver BD queues (8 byte elements) use the
+ * specialized ipc_queue_push64()/ipc_queue_pop64() operations instead, so the
+ * burst (push_n/pop_n) and zero-copy (reserve/commit, peek/consume) operations
+ * are not used by the driver and are kept for queues of other element sizes.
+ */
 int ipc_queue_push(struct ipc_queue *queue, const void *buf);
 int ipc_queue_pop(struct ipc_queue *queue, void *buf);
+void *ipc_queue_reserve(struct ipc_queue *queue);
+int ipc_queue_commit(struct ipc_queue *queue);
+const void *ipc_queue_peek(struct ipc_queue *queue);
+int ipc_queue_consume(struct ipc_queue *queue);
+int ipc_queue_push_n(struct ipc_queue *queue, const void *buf, uint32_t n);
+int ipc_queue_pop_n(struct ipc_queue *queue, void *buf, uint32_t n);
 int ipc_queue_check_integrity(struct ipc_queue *queue);
+uint32_t ipc_queue_count(struct ipc_queue *queue);
+uint32_t ipc_queue_space(struct ipc_queue *queue);
+int ipc_queue_push64_mp(struct ipc_queue *queue, uint64_t elem);
+int ipc_queue_pop64_mc(struct ipc_queue *queue, uint64_t *elem);
+
+/*
+ * Variable length messages: queue elements are IPC_QUEUE_MSG_ELEM_SIZE bytes
+ * and each message occupies a header element followed by its payload.
+ */
+uint32_t ipc_queue_msg_max_size(const struct ipc_queue *queue);
+int ipc_queue_msg_push(struct ipc_queue *queue, const void *buf,
+	uint32_t size);
+int ipc_queue_msg_peek(struct ipc_queue *queue, const void **buf,
+	uint32_t *size);
+int ipc_queue_msg_consume(struct ipc_queue *queue);
 
 /**
  * ipc_queue_mem_size() - return queue footprint in local mapped memory
@@ -65,9 +213,331 @@ int ipc_queue_check_integrity(struct ipc_queue *queue);
  */
 static inline uint32_t ipc_queue_mem_size(struct ipc_queue *queue)
 {
+	uint32_t size = (uint32_t)queue->elem_num * (uint32_t)queue->elem_size;
+
+	/* padded rings don't share their last cache line with next data */
+	if ((queue->flags & IPC_QUEUE_PADDED) != 0u) {
+		return (uint32_t)sizeof(struct ipc_ring_padded)
+			+ IPC_QUEUE_ALIGN(size);
+	}
+
 	/* local ring control room + ring size */
-	return (uint32_t)sizeof(struct ipc_ring)
-		+ ((uint32_t)queue->elem_num * (uint32_t)queue->elem_size);
+	return (uint32_t)sizeof(struct ipc_ring) + size;
+}
+
+/**
+ * ipc_queue_used() - number of elements stored in ring
+ * @queue:	[IN] queue pointer
+ * @write:	[IN] ring write index
+ * @read:	[IN] ring read index
+ */
+static inline uint32_t ipc_queue_used(const struct ipc_queue *queue,
+		uint32_t write, uint32_t read)
+{
+	/* free-running indexes: unsigned difference handles wrap around */
+	if ((queue->flags & IPC_QUEUE_POW2) != 0u) {
+		return write - read;
+	}
+
+	return (write + queue->elem_num - read) % queue->elem_num;
+}
+
+/**
+ * ipc_queue_room() - number of elements that can still be pushed in ring
+ * @queue:	[IN] queue pointer
+ * @write:	[IN] ring write index
+ * @read:	[IN] ring read index
+ */
+static inline uint32_t ipc_queue_room(const struct ipc_queue *queue,
+		uint32_t write, uint32_t read)
+{
+	/* free-running indexes can use all elements of the ring */
+	if ((queue->flags & IPC_QUEUE_POW2) != 0u) {
+		return queue->elem_num - (write - read);
+	}
+
+	/* one element is kept as sentinel between write and read index */
+	return (read + queue->elem_num - write - 1u) % queue->elem_num;
+}
+
+/**
+ * ipc_queue_slot() - ring element position of an index
+ * @queue:	[IN] queue pointer
+ * @index:	[IN] ring write or read index
+ */
+static inline uint32_t ipc_queue_slot(const struct ipc_queue *queue,
+		uint32_t index)
+{
+	if ((queue->flags & IPC_QUEUE_POW2) != 0u) {
+		return index & queue->mask;
+	}
+
+	return index;
+}
+
+/**
+ * ipc_queue_advance() - increment ring index with wrap around
+ * @queue:	[IN] queue pointer
+ * @index:	[IN] ring write or read index
+ * @count:	[IN] number of elements to advance (at most elem_num)
+ */
+static inline uint32_t ipc_queue_advance(const struct ipc_queue *queue,
+		uint32_t index, uint32_t count)
+{
+	/* free-running indexes wrap around naturally at max uint32_t */
+	if ((queue->flags & IPC_QUEUE_POW2) != 0u) {
+		return index + count;
+	}
+
+	return (index + count) % queue->elem_num;
+}
+
+/**
+ * ipc_queue_pop_avail() - number of elements available for pop
+ * @queue:	[IN] queue pointer
+ * @read:	[IN] pop ring read index
+ * @n:		[IN] number of elements needed by caller
+ *
+ * Count is computed from the shadow copy of the remote write index, which is
+ * refreshed from remote memory only when it doesn't cover n elements. The
+ * shadow can only lag behind the remote index, so the count is never
+ * overestimated. The remote index is loaded with acquire semantics, so the
+ * elements it covers are read only after the remote has written them.
+ */
+static inline uint32_t ipc_queue_pop_avail(struct ipc_queue *queue,
+		uint32_t read, uint32_t n)
+{
+	uint32_t count = ipc_queue_used(queue, queue->remote_write, read);
+
+	if (count < n) {
+		queue->remote_write = ipc_os_load_acquire(queue->pop.write);
+		count = ipc_queue_used(queue, queue->remote_write, read);
+	}
+
+	return count;
+}
+
+/**
+ * ipc_queue_count_lazy() - number of elements in queue, if less than n
+ * @queue:	[IN] queue pointer
+ * @n:		[IN] number of elements of interest to caller
+ *
+ * Count is computed from the local read index and the shadow copy of the
+ * remote write index, which is refreshed from remote memory only when it
+ * covers less than n elements, so the count is exact when less than n. The
+ * shadow is maintained only by single consumer pops, so the count is not
+ * meaningful in IPC_QUEUE_MC mode.
+ */
+static inline uint32_t ipc_queue_count_lazy(struct ipc_queue *queue,
+		uint32_t n)
+{
+	/* read indexes of push/pop rings are swapped (interference freedom) */
+	return ipc_queue_pop_avail(queue, *queue->push.read, n);
+}
+
+/**
+ * ipc_queue_push_room() - number of elements that can be pushed
+ * @queue:	[IN] queue pointer
+ * @write:	[IN] push ring write index
+ * @n:		[IN] number of elements needed by caller
+ *
+ * Room is computed from the shadow copy of the remote read index, which is
+ * refreshed from remote memory only when it doesn't cover n elements. The
+ * shadow can only lag behind the remote index, so the room is never
+ * overestimated. The remote index is loaded with acquire semantics, so the
+ * elements it frees are overwritten only after the remote has read them.
+ */
+static inline uint32_t ipc_queue_push_room(struct ipc_queue *queue,
+		uint32_t write, uint32_t n)
+{
+	uint32_t room = ipc_queue_room(queue, write, queue->remote_read);
+
+	if (room < n) {
+		queue->remote_read = ipc_os_load_acquire(queue->pop.read);
+		room = ipc_queue_room(queue, write, queue->remote_read);
+	}
+
+	return room;
+}
+
+/**
+ * ipc_queue_push64() - pushes an 8 byte element into the queue
+ * @queue:	[IN] queue pointer (initialized with 8 byte elements)
+ * @elem:	[IN] element to be pushed into the queue
+ *
+ * Specialized ipc_queue_push() for queues of 8 byte elements (e.g. buffer
+ * descriptors): the element is written with a single 64-bit store and the slot
+ * offset is computed with a shift. No argument validation is done.
+ * Safe for concurrent producers in IPC_QUEUE_MP mode.
+ *
+ * Return:	0 on success, -ENOMEM if queue is full
+ */
+static inline int ipc_queue_push64(struct ipc_queue *queue, uint64_t elem)
+{
+	uint32_t write; /* cache write index for thread-safety */
+
+	if ((queue->flags & IPC_QUEUE_MP) != 0u) {
+		return ipc_queue_push64_mp(queue, elem);
+	}
+
+	write = *queue->push.write;
+
+	if (ipc_queue_push_room(queue, write, 1u) == 0u) {
+		return -ENOMEM;
+	}
+
+	((uint64_t *)queue->push.data)[ipc_queue_slot(queue, write)] = elem;
+
+	/* increment write index with wrap around, after element is written */
+	ipc_os_store_release(queue->push.write,
+		ipc_queue_advance(queue, write, 1u));
+
+	return 0;
+}
+
+/**
+ * ipc_queue_push64_n() - pushes up to n 8 byte elements into the queue
+ * @queue:	[IN] queue pointer (initialized with 8 byte elements)
+ * @elems:	[IN] elements to be pushed into the queue
+ * @n:		[IN] number of elements
+ *
+ * Specialized ipc_queue_push_n() for queues of 8 byte elements: elements are
+ * copied with 64-bit stores and the write index is published once for the
+ * entire burst. In IPC_QUEUE_MP mode elements are pushed one by one, so they
+ * may be interleaved with elements of other producers. No argument validation
+ * is done.
+ *
+ * Return:	number of elements pushed (0 if queue is full)
+ */
+static inline int ipc_queue_push64_n(struct ipc_queue *queue,
+		const uint64_t *elems, uint32_t n)
+{
+	uint64_t *data = (uint64_t *)queue->push.data;
+	uint32_t write; /* cache write index for thread-safety */
+	uint32_t count, slot, i;
+
+	if ((queue->flags & IPC_QUEUE_MP) != 0u) {
+		for (i = 0; i < n; i++) {
+			if (ipc_queue_push64_mp(queue, elems[i]) != 0) {
+				break;
+			}
+		}
+		return (int)i;
+	}
+
+	write = *queue->push.write;
+
+	count = ipc_queue_push_room(queue, write, n);
+	if (count > n) {
+		count = n;
+	}
+
+	slot = ipc_queue_slot(queue, write);
+	for (i = 0; i < count; i++) {
+		data[slot] = elems[i];
+		slot++;
+		if (slot == queue->elem_num) {
+			slot = 0;
+		}
+	}
+
+	/* publish write index once for the entire burst */
+	if (count != 0u) {
+		ipc_os_store_release(queue->push.write,
+			ipc_queue_advance(queue, write, count));
+	}
+
+	return (int)count;
+}
+
+/**
+ * ipc_queue_pop64() - removes an 8 byte element from queue
+ * @queue:	[IN] queue pointer (initialized with 8 byte elements)
+ * @elem:	[OUT] removed element
+ *
+ * Specialized ipc_queue_pop() for queues of 8 byte elements: the element is
+ * read with a single 64-bit load. No argument validation is done.
+ * Safe for concurrent consumers in IPC_QUEUE_MC mode.
+ *
+ * Return:	0 on success, -ENOBUFS if queue is empty
+ */
+static inline int ipc_queue_pop64(struct ipc_queue *queue, uint64_t *elem)
+{
+	uint32_t read; /* cache read index for thread-safety */
+
+	if ((queue->flags & IPC_QUEUE_MC) != 0u) {
+		return ipc_queue_pop64_mc(queue, elem);
+	}
+
+	/* read indexes of push/pop rings are swapped (interference freedom) */
+	read = *queue->push.read;
+
+	if (ipc_queue_pop_avail(queue, read, 1u) == 0u) {
+		return -ENOBUFS;
+	}
+
+	*elem = ((const uint64_t *)queue->pop.data)[ipc_queue_slot(queue, read)];
+
+	/* increment read index with wrap around, after element is read */
+	ipc_os_store_release(queue->push.read,
+		ipc_queue_advance(queue, read, 1u));
+
+	return 0;
+}
+
+/**
+ * ipc_queue_pop64_n() - removes up to n 8 byte elements from queue
+ * @queue:	[IN] queue pointer (initialized with 8 byte elements)
+ * @elems:	[OUT] removed elements
+ * @n:		[IN] maximum number of elements to remove
+ *
+ * Specialized ipc_queue_pop_n() for queues of 8 byte elements: elements are
+ * copied with 64-bit loads and the read index is published once for the
+ * entire burst. In IPC_QUEUE_MC mode elements are popped one by one, so other
+ * consumers may get elements in between. No argument validation is done.
+ *
+ * Return:	number of elements removed (0 if queue is empty)
+ */
+static inline int ipc_queue_pop64_n(struct ipc_queue *queue, uint64_t *elems,
+		uint32_t n)
+{
+	const uint64_t *data = (const uint64_t *)queue->pop.data;
+	uint32_t read; /* cache read index for thread-safety */
+	uint32_t count, slot, i;
+
+	if ((queue->flags & IPC_QUEUE_MC) != 0u) {
+		for (i = 0; i < n; i++) {
+			if (ipc_queue_pop64_mc(queue, &elems[i]) != 0) {
+				break;
+			}
+		}
+		return (int)i;
+	}
+
+	/* read indexes of push/pop rings are swapped (interference freedom) */
+	read = *queue->push.read;
+
+	count = ipc_queue_pop_avail(queue, read, n);
+	if (count > n) {
+		count = n;
+	}
+
+	slot = ipc_queue_slot(queue, read);
+	for (i = 0; i < count; i++) {
+		elems[i] = data[slot];
+		slot++;
+		if (slot == queue->elem_num) {
+			slot = 0;
+		}
+	}
+
+	/* publish read index once for the entire burst */
+	if (count != 0u) {
+		ipc_os_store_release(queue->push.read,
+			ipc_queue_advance(queue, read, count));
+	}
+
+	return (int)count;
 }
 
 #endif /* IPC_QUEUE_H */
@@ -8,14 +8,49 @@
 #include "ipc-shm.h"
 
 #define ipc_max(x, y) (((x) > (y)) ? (x) : (y))
+#define ipc_min(x, y) (((x) < (y)) ? (x) : (y))
+
+/* max number of BDs popped at once from a channel queue in Rx handler */
+#define IPC_SHM_RX_BATCH 16
+
+/* max number of BDs pushed/popped at once by batched Tx and acquire */
+#define IPC_SHM_TX_BATCH 16
+
+/* round descriptor sizes so that all descriptors are 8 byte aligned */
+#define IPC_SHM_DESC_ALIGN(size) (((size) + 7u) & ~((size_t)7u))
 
 /* magic number to indicate the driver is initialized */
 #define IPC_SHM_STATE_READY 0x3252455646435049ULL
 #define IPC_SHM_STATE_CLEAR 0u
 
+/* number of buffer request size classes: ceil(log2(size)) for 32-bit sizes */
+#define IPC_SHM_SIZE_CLASSES 33
+
+/* buf_shift value of pools with buffer size not a power of two */
+#define IPC_SHM_BUF_SHIFT_NONE 0xFFu
+
+/* BD flag: next BD in channel queue belongs to the same message */
+#define IPC_SHM_BD_MORE 0x01u
+
+/* BD flag: buffer holds a fragment of a message sent by ipc_shm_tx_large() */
+#define IPC_SHM_BD_LARGE 0x02u
+
+/*
+ * BD format version (8-bit pool index followed by flags), encoded with the BD
+ * flags negotiated by the channel in the BD queue sentinels, so that a remote
+ * using another BD format or other message options fails the integrity check.
+ * Channels without BD flags keep the legacy sentinels: their BDs (flags 0,
+ * pool index below 256) are identical to the legacy 16-bit pool index layout.
+ */
+#define IPC_SHM_BD_FORMAT 0x01u
+#define IPC_SHM_BD_FLAGS_SHIFT 4u
+
 /* magic number to indicate the unmanaged channel integrity */
 #define IPC_UCHAN_SENTINEL 0x55435049UL
 
+/* unmanaged channel layout options are encoded in the sentinel low byte */
+#define IPC_UCHAN_SENTINEL_FLAGS_MASK ((uint32_t)IPC_SHM_UMNG_SNAPSHOT)
+
 /**
  * enum ipc_shm_instance_state - used for IPC instance status
  * @IPC_SHM_INSTANCE_USED:	instance is used
@@ -31,23 +66,50 @@ enum ipc_shm_instance_state {
 /**
  * struct ipc_shm_bd - buffer descriptor (store buffer location and data size)
  * @pool_id:	index of buffer pool
+ * @flags:	buffer descriptor flags (IPC_SHM_BD_MORE, IPC_SHM_BD_LARGE)
  * @buf_id:	index of buffer from buffer pool
  * @data_size:	size of data written in buffer
+ *
+ * A scatter-gather message is sent as a chain of BDs pushed back to back, all
+ * but the last one having IPC_SHM_BD_MORE flag set.
  */
 struct ipc_shm_bd {
-	int16_t pool_id;
+	uint8_t pool_id;
+	uint8_t flags;
 	uint16_t buf_id;
 	uint32_t data_size;
 };
 
+/**
+ * union ipc_shm_bd_elem - buffer descriptor as BD queue element
+ * @bd:		buffer descriptor
+ * @word:	buffer descriptor moved with a single 64-bit access
+ *
+ * BD queues use the 8 byte element specialized queue operations.
+ */
+union ipc_shm_bd_elem {
+	struct ipc_shm_bd bd;
+	uint64_t word;
+};
+
 /**
  * struct ipc_shm_pool - buffer pool private data
  * @num_bufs:		number of buffers in pool
  * @buf_size:		size of buffers
+ * @buf_shift:		log2 of buf_size if power of two, IPC_SHM_BUF_SHIFT_NONE
+ *			otherwise
  * @shm_size:		size of shared memory mapped by this pool (queue + bufs)
  * @local_pool_addr:	address of local buffer pool
  * @remote_pool_addr:	address of remote buffer pool
  * @bd_queue:		queue containing BDs of free buffers
+ * @local_ts:		Tx timestamp of each local buffer (timestamp channels)
+ * @remote_ts:		Tx timestamp of each remote buffer (timestamp channels)
+ * @stats:		pool runtime statistics
+ * @large_plan:		free buffers left while planning a large message
+ * @large_avail:	free buffers left while sending a large message
+ * @rel_count:		number of BDs in release cache
+ * @rel_cache:		BDs of released buffers not yet pushed in release ring
+ *			(IPC_SHM_RELEASE_CACHE_SIZE entries)
  *
  * bd_queue has two rings: one for pushing BDs (release ring) and one for
  * popping BDs (acquire ring).
@@ -59,23 +121,101 @@ struct ipc_shm_bd {
  * The relation between local and remote bd_queue rings is:
  *     local acquire ring == remote release ring
  *     local release ring == remote acquire ring
+ *
+ * With IPC_SHM_CHAN_TIMESTAMP, the pool buffers are followed by an array with
+ * the Tx timestamp of each buffer, written by the owner of the buffers before
+ * sending it and read by remote before calling the Rx callback.
+ *
+ * With deferred release, BDs are first stored in the local release cache and
+ * pushed together in release ring, so that remote sees one index update.
  */
 struct ipc_shm_pool {
 	uint16_t num_bufs;
 	uint32_t buf_size;
+	uint8_t buf_shift;
 	uint32_t shm_size;
 	uintptr_t local_pool_addr;
 	uintptr_t remote_pool_addr;
 	struct ipc_queue bd_queue;
+	uint64_t *local_ts;
+	uint64_t *remote_ts;
+	struct ipc_shm_pool_stats stats;
+	uint32_t large_plan;
+	uint32_t large_avail;
+	int rel_count;
+	uint64_t *rel_cache;
+};
+
+/**
+ * struct ipc_shm_pool_range - address range of pool buffers
+ * @start:	address of first buffer
+ * @end:	address after last buffer
+ */
+struct ipc_shm_pool_range {
+	uintptr_t start;
+	uintptr_t end;
+};
+
+/**
+ * struct ipc_managed_rx_state - managed channel state used by rare Rx paths
+ * @sg_count:	number of buffers received so far of a scatter-gather message
+ * @sg:		buffers received so far of a scatter-gather message
+ * @large_owned:	reassembly buffer allocated by driver (not app)
+ * @large_size:	size of reassembly buffer
+ * @large_len:	bytes reassembled so far of a large message
+ * @large_err:	large message being received doesn't fit reassembly buffer
+ * @latency:	Tx to Rx callback latency histogram (timestamp channels)
+ * @latency_seq:	latency histogram sequence counter, odd while the Rx
+ *			handler or a statistics reset updates the histogram
+ *
+ * A scatter-gather message may span several Rx passes (budget exhausted or
+ * chain not yet fully popped), so its buffers are gathered in channel data.
+ * Large message fragments are copied in the reassembly buffer as they arrive
+ * and their buffers are released right away, concurrently with app releases
+ * (see ipc_large_rx()).
+ */
+struct ipc_managed_rx_state {
+	int sg_count;
+	struct ipc_shm_sg_buf sg[IPC_SHM_MAX_SG_BUFS];
+	bool large_owned;
+	uint32_t large_size;
+	uint32_t large_len;
+	bool large_err;
+	struct ipc_shm_chan_latency latency;
+	uint32_t latency_seq;
 };
 
 /**
  * struct ipc_managed_channel - managed channel private data
  * @bd_queue:	queue containing BDs of sent/received buffers
  * @num_pools:	number of buffer pools
- * @pools:	buffer pools private data
+ * @pools:	buffer pools private data (num_pools entries)
  * @rx_cb:	receive callback
+ * @rx_sg_cb:	optional scatter-gather receive callback
  * @cb_arg:	optional receive callback argument
+ * @flags:	channel options from &enum ipc_shm_channel_flags
+ * @queue_flags:	local threading flags of channel queues (IPC_QUEUE_MP/MC)
+ * @bd_flags:	BD flags negotiated with remote (IPC_SHM_BD_MORE/LARGE), BDs
+ *		received with other flags are dropped
+ * @local_range:	local buffer address range of each pool
+ * @remote_range:	remote buffer address range of each pool
+ * @size_class:	first pool that may accommodate each request size class
+ *		(IPC_SHM_SIZE_CLASSES entries)
+ * @large_buf:	reassembly buffer of large messages (NULL if disabled)
+ * @rel_lock:	serializes release cache updates and flushes of all pools
+ * @rel_in_rx:	an Rx pass of the channel is running and flushes the release
+ *		cache when it ends
+ * @rx:		state of scatter-gather, reassembly and latency Rx paths
+ *
+ * Pool descriptors, address range tables and the size class table are
+ * allocated at init, next to each other, from the hot area of the instance
+ * descriptor memory (see ipc_shm_desc_alloc()). Release caches and the Rx
+ * state are allocated from its cold area, and the reassembly buffer, if not
+ * provided by app, apart from the descriptors, so that they don't split the
+ * hot descriptors.
+ *
+ * Pools are mapped in ascending address order, so the address range tables
+ * are sorted and the pool owning a buffer is the first one ending after it.
  *
  * bd_queue has two rings: one for pushing BDs (Tx ring) and one for popping
  * BDs (Rx ring).
@@ -89,10 +229,22 @@ struct ipc_shm_pool {
 struct ipc_managed_channel {
 	struct ipc_queue bd_queue;
 	int num_pools;
-	struct ipc_shm_pool pools[IPC_SHM_MAX_POOLS];
+	struct ipc_shm_pool *pools;
 	void (*rx_cb)(void *cb_arg, const uint8_t instance, int chan_id,
 			void *buf, size_t size);
+	void (*rx_sg_cb)(void *cb_arg, const uint8_t instance, int chan_id,
+			const struct ipc_shm_sg_buf *sg, int n);
 	void *cb_arg;
+	uint32_t flags;
+	uint8_t queue_flags;
+	uint8_t bd_flags;
+	struct ipc_shm_pool_range *local_range;
+	struct ipc_shm_pool_range *remote_range;
+	uint16_t *size_class;
+	uint8_t *large_buf;
+	uint32_t rel_lock;
+	bool rel_in_rx;
+	struct ipc_managed_rx_state *rx;
 };
 
 /**
@@ -103,13 +255,35 @@ struct ipc_managed_channel {
  *
  * tx_count is used by remote peer in Rx intr handler to determine if this
  * channel had a Tx operation and decide whether to call the app Rx callback.
+ * It is published with release semantics, after the app has written the
+ * channel memory.
  */
 struct ipc_channel_umem {
 	uint32_t sentinel;
-	volatile uint32_t tx_count;
+	uint32_t tx_count;
 	uint8_t mem[];
 };
 
+/**
+ * struct ipc_umem_slots - snapshot unmanaged channel memory (four-slot)
+ * @latest:	pair holding the latest snapshot written by local (writer)
+ * @slot:	slot holding the latest snapshot of each pair (writer)
+ * @reading:	pair of remote memory being read by local (reader)
+ * @data:	four slots of slot_size bytes, slot i of pair p at index 2p + i
+ *
+ * Mapped in the mem area of &struct ipc_channel_umem for IPC_SHM_UMNG_SNAPSHOT
+ * channels. Each control word is written only by its owner side, in its local
+ * memory: the writer never writes the pair being read and the reader always
+ * reads the latest complete slot, without retries (Simpson's four-slot
+ * asynchronous communication mechanism).
+ */
+struct ipc_umem_slots {
+	uint32_t latest;
+	uint32_t slot[2];
+	uint32_t reading;
+	uint8_t data[];
+};
+
 /**
  * struct ipc_unmanaged_channel - unmanaged channel private data
  * @size:		unmanaged channel memory size requested by app
@@ -118,6 +292,14 @@ struct ipc_channel_umem {
  * @remote_tx_count:	copy of remote Tx counter
  * @rx_cb:		receive callback
  * @cb_arg:		optional receive callback argument
+ * @flags:		channel options from &enum ipc_shm_unmanaged_flags
+ * @sentinel:		expected sentinel of local and remote channel memory
+ *			(encodes layout options)
+ * @slot_size:		snapshot slot size (size rounded up to 8 bytes)
+ * @local_slots:	local snapshot slots (IPC_SHM_UMNG_SNAPSHOT only)
+ * @remote_slots:	remote snapshot slots (IPC_SHM_UMNG_SNAPSHOT only)
+ * @wr_pair:		pair of slot acquired for writing
+ * @wr_slot:		slot acquired for writing
  */
 struct ipc_unmanaged_channel {
 	uint32_t size;
@@ -127,51 +309,266 @@ struct ipc_unmanaged_channel {
 	void (*rx_cb)(void *cb_arg, const uint8_t instance, int chan_id,
 			void *buf);
 	void *cb_arg;
+	uint32_t flags;
+	uint32_t sentinel;
+	uint32_t slot_size;
+	struct ipc_umem_slots *local_slots;
+	struct ipc_umem_slots *remote_slots;
+	uint32_t wr_pair;
+	uint32_t wr_slot;
+};
+
+/**
+ * struct ipc_inline_channel - inline channel private data
+ * @queue:	queue containing variable length messages
+ * @rx_cb:	receive callback
+ * @cb_arg:	optional receive callback argument
+ *
+ * Messages are copied in queue push ring by local IPC and handed to the app
+ * in place from queue pop ring (remote push ring) by the Rx handler.
+ */
+struct ipc_inline_channel {
+	struct ipc_queue queue;
+	void (*rx_cb)(void *cb_arg, const uint8_t instance, int chan_id,
+			void *buf, size_t size);
+	void *cb_arg;
 };
 
 /**
  * struct ipc_shm_channel - ipc channel private data
  * @id:		channel id
  * @type:	channel type (see ipc_shm_channel_type)
- * @ch:		managed/unmanaged channel private data
+ * @integrity_err:	latched integrity error (sampled/background policies)
+ * @integrity_calls:	API calls since last integrity check (sampled policy)
+ * @priority:	Rx scheduling priority
+ * @weight:	Rx budget share among channels with same priority
+ * @rx_pending:	channel may have more messages in current Rx pass
+ * @stats:	channel runtime statistics (updated by each operation)
+ * @ch:		managed/unmanaged/inline channel private data
  */
 struct ipc_shm_channel {
 	int id;
 	enum ipc_shm_channel_type type;
+	int integrity_err;
+	uint32_t integrity_calls;
+	uint8_t priority;
+	uint32_t weight;
+	bool rx_pending;
+	struct ipc_shm_chan_stats stats;
 	union {
 		struct ipc_managed_channel mng;
 		struct ipc_unmanaged_channel umng;
+		struct ipc_inline_channel inl;
 	} ch;
 };
 
+/**
+ * struct ipc_chan_sel - channels selected for an Rx run
+ * @mask:	channel bitmap, bit i of word w selects channel base + 32w + i
+ * @base:	id of channel selected by bit 0 of first word (multiple of 32)
+ * @len:	number of 32-bit words of bitmap
+ *
+ * Rx runs of the softirq handler and of ipc_shm_poll_channels() use a NULL
+ * selection, which selects all channels.
+ */
+struct ipc_chan_sel {
+	const uint32_t *mask;
+	int base;
+	int len;
+};
+
 /**
  * struct ipc_shm_global - ipc shm global data shared with remote
  * @state:		state to indicate whether local is initialized
+ * @rx_active:		local Rx runs are processing received messages (0 or 1)
+ * @reserved:		reserved, keeps memory alignment
  *
  * Global data is located at beginning of local/remote shared memory so the size
  * of this struct should chosen so that memory alignment is preserved.
+ *
+ * Only state is mapped in shared memory unless IPC_SHM_NOTIFY_SUPPRESS is
+ * enabled (see get_global_size()).
  */
 struct ipc_shm_global {
 	uint64_t state;
+	uint32_t rx_active;
+	uint32_t reserved;
 };
 
 /**
  * struct ipc_shm_priv - ipc shm private data
  * @shm_size:		local/remote shared memory size
  * @num_channels:	number of shared memory channels
- * @channels:		ipc channels private data
+ * @queue_flags:	ring layout flags used for all instance queues
+ * @flags:		instance options (see ipc_shm_instance_flags)
+ * @integrity_policy:	channel integrity check policy
+ * @integrity_period:	API calls between checks (sampled policy)
+ * @rx_irq:		inter-core Rx interrupt (IPC_IRQ_NONE for polling)
+ * @channels:		ipc channels private data (num_channels entries)
+ * @rx_order:		channel ids sorted by descending Rx priority
  * @global:		local global data shared with remote
+ * @rx_active:		number of local Rx runs processing received messages,
+ *			published to remote in global data
+ * @desc_mem:		memory of channel and pool descriptors
+ * @desc_size:		size of descriptor memory
+ * @desc_hot_size:	size of hot descriptor area, at start of desc_mem
+ * @desc_used:		size of hot descriptor area already assigned
+ * @desc_cold_used:	size of cold descriptor area already assigned
+ * @desc_owned:		descriptor memory allocated by driver (not app arena)
+ *
+ * Channel descriptors and rx_order, followed by the pool descriptors of each
+ * managed channel, are allocated at init in one block sized from the instance
+ * configuration, so that the hot data of an instance is contiguous. State used
+ * only by rare paths (scatter-gather and large message Rx, latency histogram,
+ * deferred release caches) is allocated after all hot descriptors.
  */
 struct ipc_shm_priv {
 	uint32_t shm_size;
 	int num_channels;
-	struct ipc_shm_channel channels[IPC_SHM_MAX_CHANNELS];
+	uint8_t queue_flags;
+	uint32_t flags;
+	enum ipc_shm_integrity_policy integrity_policy;
+	uint32_t integrity_period;
+	int rx_irq;
+	struct ipc_shm_channel *channels;
+	uint16_t *rx_order;
 	struct ipc_shm_global *global;
+	uint32_t rx_active;
+	void *desc_mem;
+	size_t desc_size;
+	size_t desc_hot_size;
+	size_t desc_used;
+	size_t desc_cold_used;
+	bool desc_owned;
 };
 
 /* ipc shm private data */
 static struct ipc_shm_priv ipc_shm_priv_data[IPC_SHM_MAX_INSTANCES];
 
+/* round shared memory area size so that next area keeps ring alignment */
+static inline uint32_t get_layout_size(const uint8_t instance, uint32_t size)
+{
+	if ((ipc_shm_priv_data[instance].queue_flags & IPC_QUEUE_PADDED) != 0u)
+		return IPC_QUEUE_ALIGN(size);
+
+	return size;
+}
+
+/* address of slot of snapshot unmanaged channel memory */
+static inline void *get_umem_slot(const struct ipc_unmanaged_channel *chan,
+		const struct ipc_umem_slots *slots, uint32_t pair, uint32_t slot)
+{
+	return (void *)((uintptr_t)slots->data
+			+ ((2u * pair) + slot) * chan->slot_size);
+}
+
+/* size of unmanaged channel control structure and memory (or slots) */
+static inline uint32_t get_umem_memmap_size(const uint8_t instance,
+		const struct ipc_unmanaged_channel *chan)
+{
+	if (chan->local_slots != NULL)
+		return get_layout_size(instance,
+			(uint32_t)(sizeof(struct ipc_channel_umem)
+				+ sizeof(struct ipc_umem_slots)
+				+ (4u * chan->slot_size)));
+
+	return get_layout_size(instance,
+		(uint32_t)(sizeof(struct ipc_channel_umem) + chan->size));
+}
+
+/* check if remote has published its initialized channels */
+static inline bool ipc_remote_is_ready(const uint8_t instance)
+{
+	const struct ipc_shm_global *remote_global =
+		(const struct ipc_shm_global *)ipc_os_get_remote_shm(instance);
+
+	return ipc_os_load_acquire(&remote_global->state)
+		== IPC_SHM_STATE_READY;
+}
+
+/* size of global data mapped at beginning of local/remote shared memory */
+static inline uint32_t get_global_size(const uint8_t instance)
+{
+	if ((ipc_shm_priv_data[instance].flags & IPC_SHM_NOTIFY_SUPPRESS) != 0u)
+		return (uint32_t)sizeof(struct ipc_shm_global);
+
+	return (uint32_t)offsetof(struct ipc_shm_global, rx_active);
+}
+
+/* get index of pool buffer located at offset from pool start */
+static inline uint16_t get_buf_id(const struct ipc_shm_pool *pool,
+		uintptr_t offset)
+{
+	if (pool->buf_shift != IPC_SHM_BUF_SHIFT_NONE)
+		return (uint16_t)(offset >> pool->buf_shift);
+
+	return (uint16_t)(offset / pool->buf_size);
+}
+
+/* get offset from pool start of pool buffer */
+static inline uintptr_t get_buf_offset(const struct ipc_shm_pool *pool,
+		uint16_t buf_id)
+{
+	if (pool->buf_shift != IPC_SHM_BUF_SHIFT_NONE)
+		return (uintptr_t)buf_id << pool->buf_shift;
+
+	return (uintptr_t)buf_id * pool->buf_size;
+}
+
+/* size class of a buffer request: ceil(log2(size)), 0 for size 1 */
+static inline uint32_t get_size_class(uint32_t size)
+{
+	uint32_t v = size - 1u;
+	uint32_t size_class = 0;
+
+	if (v >= (1u << 16)) {
+		v >>= 16;
+		size_class += 16u;
+	}
+	if (v >= (1u << 8)) {
+		v >>= 8;
+		size_class += 8u;
+	}
+	if (v >= (1u << 4)) {
+		v >>= 4;
+		size_class += 4u;
+	}
+	if (v >= (1u << 2)) {
+		v >>= 2;
+		size_class += 2u;
+	}
+	if (v >= (1u << 1)) {
+		v >>= 1;
+		size_class += 1u;
+	}
+
+	return size_class + v;
+}
+
+/**
+ * get_first_pool() - get first pool with buffers that accommodate a size
+ * @chan:	managed channel
+ * @size:	requested buffer size
+ *
+ * Return: pool index, num_pools if no pool accommodates the size
+ */
+static inline int get_first_pool(const struct ipc_managed_channel *chan,
+		size_t size)
+{
+	int pool_id;
+
+	if (((uint64_t)size >> 32) != 0u)
+		return chan->num_pools;
+
+	/* pools in size class may be too small for sizes at its lower end */
+	pool_id = chan->size_class[get_size_class((uint32_t)size)];
+	while ((pool_id < chan->num_pools)
+			&& (size > chan->pools[pool_id].buf_size))
+		pool_id++;
+
+	return pool_id;
+}
+
 /* get channel without validation (used in internal functions only) */
 static inline struct ipc_shm_channel *get_channel_priv(const uint8_t instance,
 		int chan_id)
@@ -193,6 +590,114 @@ static inline struct ipc_shm_channel *get_channel(const uint8_t instance,
 	return get_channel_priv(instance, chan_id);
 }
 
+/* get channel statistics without validation */
+static inline struct ipc_shm_chan_stats *get_chan_stats(const uint8_t instance,
+		int chan_id)
+{
+	return &get_channel_priv(instance, chan_id)->stats;
+}
+
+/*
+ * Add a value to a channel statistics counter. Counters updated by concurrent
+ * threads (shared) use compare and swap, the others a plain add.
+ */
+#define ipc_stat_add(cnt, val, shared) \
+	do { \
+		__typeof__(*(cnt)) __ipc_cnt; \
+		if (shared) { \
+			do { \
+				__ipc_cnt = ipc_os_load_acquire(cnt); \
+			} while (!ipc_os_cas(cnt, __ipc_cnt, \
+					__ipc_cnt + (val))); \
+		} else { \
+			*(cnt) += (val); \
+		} \
+	} while (0)
+
+/*
+ * lower a pool low-water mark to the number of free buffers, if less: free
+ * buffers are counted from local and shadow ring indexes, remote memory is
+ * read only when the shadow count is below the mark, and the shadow isn't
+ * maintained by concurrent (shared) consumers
+ */
+static inline void ipc_stat_low_water(uint32_t *mark,
+		struct ipc_queue *queue, bool shared)
+{
+	uint32_t free_bufs;
+
+	if (shared)
+		return;
+
+	free_bufs = ipc_queue_count_lazy(queue, *mark);
+	if (free_bufs < *mark)
+		*mark = free_bufs;
+}
+
+/*
+ * start an update of channel latency histogram: the sequence counter is made
+ * odd with a compare and swap, so that the Rx handler and a statistics reset
+ * don't update it together, in the same critical section as queue tickets so
+ * that in kernel space the Rx softirq never spins on a reset it interrupted
+ */
+static inline void ipc_latency_write_begin(struct ipc_managed_rx_state *rx)
+{
+	uint32_t seq;
+
+	ipc_os_ticket_enter();
+	do {
+		seq = ipc_os_load_acquire(&rx->latency_seq);
+		if ((seq & 1u) != 0u)
+			ipc_os_cpu_relax();
+	} while (((seq & 1u) != 0u)
+			|| !ipc_os_cas(&rx->latency_seq, seq, seq + 1u));
+
+	/* odd sequence is visible before histogram is changed */
+	ipc_os_mb();
+}
+
+static inline void ipc_latency_write_end(struct ipc_managed_rx_state *rx)
+{
+	ipc_os_store_release(&rx->latency_seq, rx->latency_seq + 1u);
+	ipc_os_ticket_exit();
+}
+
+/**
+ * ipc_latency_record() - add a message latency to channel histogram
+ * @rx:		managed channel Rx state
+ * @tx_ts:	Tx timestamp of message
+ * @rx_ts:	Rx timestamp of message
+ *
+ * Called only by the Rx handler. The update is wrapped in a sequence counter,
+ * so that ipc_shm_get_chan_latency() gets a consistent histogram.
+ */
+static void ipc_latency_record(struct ipc_managed_rx_state *rx,
+		uint64_t tx_ts, uint64_t rx_ts)
+{
+	struct ipc_shm_chan_latency *lat = &rx->latency;
+	uint64_t delta = 0;
+	uint32_t bucket = 0;
+
+	/* counters of both cores are synchronized, ignore read skew */
+	if (rx_ts > tx_ts)
+		delta = rx_ts - tx_ts;
+
+	while ((bucket < (IPC_SHM_LATENCY_BUCKETS - 1u))
+			&& ((delta >> (bucket + 1u)) != 0u))
+		bucket++;
+
+	ipc_latency_write_begin(rx);
+
+	if ((lat->count == 0u) || (delta < lat->min))
+		lat->min = delta;
+	if (delta > lat->max)
+		lat->max = delta;
+	lat->sum += delta;
+	lat->count++;
+	lat->buckets[bucket]++;
+
+	ipc_latency_write_end(rx);
+}
+
 /* get managed channel with validation */
 static inline struct ipc_managed_channel *get_managed_chan(
 		const uint8_t instance, int chan_id)
@@ -227,12 +732,31 @@ static inline struct ipc_unmanaged_channel *get_unmanaged_chan(
 	return &chan->ch.umng;
 }
 
-/* check integrity of uchan: the boundaries have not been altered */
+/* get inline channel with validation */
+static inline struct ipc_inline_channel *get_inline_chan(
+		const uint8_t instance, int chan_id)
+{
+	struct ipc_shm_channel *chan = get_channel(instance, chan_id);
+
+	if (chan == NULL)
+		return NULL;
+
+	if (chan->type != IPC_SHM_INLINE) {
+		shm_err("Invalid channel type for this operation\n");
+		return NULL;
+	}
+
+	return &chan->ch.inl;
+}
+
+/*
+ * check integrity of uchan: the boundaries have not been altered and remote
+ * uses the same layout options
+ */
 static int ipc_check_uchan_integrity(const struct ipc_unmanaged_channel *uchan)
 {
-	if ((uchan->local_mem->sentinel == (uint32_t)IPC_UCHAN_SENTINEL)
-			&& (uchan->remote_mem->sentinel
-				== (uint32_t)IPC_UCHAN_SENTINEL))
+	if ((uchan->local_mem->sentinel == uchan->sentinel)
+			&& (uchan->remote_mem->sentinel == uchan->sentinel))
 		return 0;
 
 	return -EINVAL;
@@ -241,7 +765,7 @@ static int ipc_check_uchan_integrity(const struct ipc_unmanaged_channel *uchan)
 /* check integrity of mchan: the boundaries have not been altered */
 static int ipc_check_mchan_integrity(struct ipc_managed_channel *mchan)
 {
-	uint8_t pool_id;
+	int pool_id;
 	struct ipc_shm_pool *pool = NULL;
 
 	if (0 == ipc_queue_check_integrity(&mchan->bd_queue)) {
@@ -257,719 +781,2674 @@ static int ipc_check_mchan_integrity(struct ipc_managed_channel *mchan)
 	return -EINVAL;
 }
 
+/* check integrity of channel: sentinels of all channel rings */
+static int ipc_check_chan_integrity(struct ipc_shm_channel *chan)
+{
+	if (chan->type == IPC_SHM_UNMANAGED)
+		return ipc_check_uchan_integrity(&chan->ch.umng);
+
+	if (chan->type == IPC_SHM_INLINE)
+		return ipc_queue_check_integrity(&chan->ch.inl.queue);
+
+	return ipc_check_mchan_integrity(&chan->ch.mng);
+}
+
 /**
- * ipc_channel_rx() - handle Rx for a single channel
+ * ipc_chan_integrity_policy() - check channel integrity as configured
  * @instance:	instance id
- * @chan_id:	channel id
- * @budget:	available work budget (number of messages to be processed)
+ * @chan_id:	channel id (already validated)
  *
- * Return:	work done
+ * With IPC_SHM_INTEGRITY_ALWAYS all sentinels are checked on every call. The
+ * other policies only test the error latched by the last check, which is done
+ * every integrity_period calls (sampled) or by ipc_shm_check_integrity() and
+ * each Rx handler run (background).
+ *
+ * Return: 0 if channel is not corrupted, error code otherwise
  */
-static int ipc_channel_rx(const uint8_t instance, int chan_id, int budget)
+static int ipc_chan_integrity_policy(const uint8_t instance, int chan_id)
 {
+	struct ipc_shm_priv *priv = &ipc_shm_priv_data[instance];
 	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
-	struct ipc_managed_channel *mchan = &chan->ch.mng;
-	struct ipc_unmanaged_channel *uchan = &chan->ch.umng;
-	struct ipc_shm_pool *pool;
-	struct ipc_shm_bd bd;
-	uintptr_t buf_addr;
-	uint32_t remote_tx_count;
+	uint32_t calls, next;
 	int err;
-	int work = 0;
-
-	/* unmanaged channels: call Rx callback if channel Tx counter changed */
-	if (chan->type == IPC_SHM_UNMANAGED) {
-		if (0 == ipc_check_uchan_integrity(uchan)) {
-			remote_tx_count = uchan->remote_mem->tx_count;
 
-			/* call Rx cb if remote Tx counter changed */
-			if (remote_tx_count != uchan->remote_tx_count) {
+	/* reached concurrently from Rx handler and producer threads: the
+	 * sampling counter and the latched error are updated atomically
+	 */
+	if (priv->integrity_policy == IPC_SHM_INTEGRITY_SAMPLED) {
+		do {
+			calls = ipc_os_load_acquire(&chan->integrity_calls);
+			next = calls + 1u;
+			if (next >= priv->integrity_period)
+				next = 0u;
+		} while (!ipc_os_cas(&chan->integrity_calls, calls, next));
+
+		if ((next == 0u) && (ipc_check_chan_integrity(chan) != 0))
+			ipc_os_store_release(&chan->integrity_err, -EINVAL);
+		err = ipc_os_load_acquire(&chan->integrity_err);
+	} else if (priv->integrity_policy == IPC_SHM_INTEGRITY_BACKGROUND) {
+		err = ipc_os_load_acquire(&chan->integrity_err);
+	} else {
+		err = ipc_check_chan_integrity(chan);
+	}
 
-				/* save new remote Tx counter */
-				uchan->remote_tx_count = remote_tx_count;
+	/* Tx and Rx side threads may both be rejected */
+	if (err != 0)
+		ipc_stat_add(&chan->stats.integrity_err, 1u, true);
 
-				uchan->rx_cb(uchan->cb_arg, instance, chan->id,
-						(void *)uchan->remote_mem->mem);
+	return err;
+}
 
-				return budget;
-			}
-			return 0;
-		}
-	}
+/* check if channel is selected for an Rx run (NULL selects all) */
+static inline bool ipc_chan_selected(const struct ipc_chan_sel *sel,
+		int chan_id)
+{
+	int bit;
 
-	/* managed channels: process incoming BDs in the limit of budget */
-	while (work < budget) {
-		err = ipc_queue_pop(&mchan->bd_queue, &bd);
-		if (err != 0) {
-			break;
-		}
-		pool = &mchan->pools[bd.pool_id];
-		buf_addr = pool->remote_pool_addr +
-			(bd.buf_id * pool->buf_size);
+	if (sel == NULL)
+		return true;
 
-		mchan->rx_cb(mchan->cb_arg, instance, chan->id,
-				(void *)buf_addr, bd.data_size);
-		work++;
-	}
+	bit = chan_id - sel->base;
+	if ((bit < 0) || (bit >= (sel->len * IPC_SHM_CHAN_MASK_BITS)))
+		return false;
 
-	return work;
+	return ((sel->mask[bit / IPC_SHM_CHAN_MASK_BITS]
+			>> (bit % IPC_SHM_CHAN_MASK_BITS)) & 1u) != 0u;
 }
 
 /**
- * ipc_instance_is_free() - determine if the instance is used or not
+ * ipc_check_selected_integrity() - check integrity of selected channels
  * @instance:	instance id
+ * @sel:	selected channels, NULL for all instance channels
  *
- * This function return the state of instance.
+ * Corrupted channels get their integrity error latched.
  *
- * Return: IPC_SHM_INSTANCE_FREE if instance is free,
- *     IPC_SHM_INSTANCE_USED otherwise or
- *     IPC_SHM_INSTANCE_ERROR if there is errors
+ * Return: 0 if no channel is corrupted, error code otherwise
  */
-static uint8_t ipc_instance_is_free(const uint8_t instance)
+static int ipc_check_selected_integrity(const uint8_t instance,
+		const struct ipc_chan_sel *sel)
 {
-	if (instance >= IPC_SHM_MAX_INSTANCES)
-		return IPC_SHM_INSTANCE_ERROR;
+	struct ipc_shm_channel *chan;
+	int err = 0;
+	int i;
 
-	if (ipc_shm_priv_data[instance].global == NULL)
-		return IPC_SHM_INSTANCE_FREE;
-	if (ipc_shm_priv_data[instance].global->state == IPC_SHM_STATE_CLEAR)
-		return IPC_SHM_INSTANCE_FREE;
+	for (i = 0; i < ipc_shm_priv_data[instance].num_channels; i++) {
+		if (!ipc_chan_selected(sel, i))
+			continue;
 
-	return IPC_SHM_INSTANCE_USED;
+		chan = get_channel_priv(instance, i);
+		if (ipc_check_chan_integrity(chan) != 0) {
+			ipc_os_store_release(&chan->integrity_err, -EINVAL);
+			err = -EINVAL;
+		}
+	}
+
+	return err;
+}
+
+/* check integrity of all instance channels */
+static inline int ipc_check_instance_integrity(const uint8_t instance)
+{
+	return ipc_check_selected_integrity(instance, NULL);
+}
+
+/*
+ * lock release cache of a channel: it is held only while a few BDs are cached
+ * or pushed, in the same critical section as queue tickets, so that in kernel
+ * space the Rx softirq never spins on a holder it interrupted
+ */
+static inline void ipc_release_lock(struct ipc_managed_channel *chan)
+{
+	ipc_os_ticket_enter();
+	while (!ipc_os_cas(&chan->rel_lock, 0u, 1u))
+		ipc_os_cpu_relax();
+}
+
+static inline void ipc_release_unlock(struct ipc_managed_channel *chan)
+{
+	ipc_os_store_release(&chan->rel_lock, 0u);
+	ipc_os_ticket_exit();
 }
 
 /**
- * ipc_shm_rx() - shm Rx handler, called from softirq
+ * ipc_release_flush_pool() - push cached released BDs of a pool in release ring
  * @instance:	instance id
- * @budget:	available work budget (number of messages to be processed)
- *
- * This function handles all channels using a fair handling algorithm: all
- * channels are treated equally and no channel is starving.
+ * @chan_id:	channel id
+ * @pool:	buffer pool
  *
- * Return:	work done
+ * Return: 0 on success, error code otherwise
  */
-static int ipc_shm_rx(const uint8_t instance, int budget)
+static int ipc_release_flush_pool(const uint8_t instance, int chan_id,
+		struct ipc_shm_pool *pool)
 {
-	int num_chans = ipc_shm_priv_data[instance].num_channels;
-	int chan_budget, chan_work;
-	int more_work = 1;
-	int work = 0;
-	int i;
+	int pushed;
 
-	/* fair channel handling algorithm */
-	while ((work < budget) && (more_work > 0)) {
-		chan_budget = ipc_max(((budget - work) / num_chans), 1);
-		more_work = 0;
-
-		for (i = 0; i < num_chans; i++) {
-			chan_work = ipc_channel_rx(instance, i, chan_budget);
-			work += chan_work;
+	if (pool->rel_count == 0)
+		return 0;
 
-			if (chan_work == chan_budget)
-				more_work = 1;
-		}
+	pushed = ipc_queue_push64_n(&pool->bd_queue, pool->rel_cache,
+			(uint32_t)pool->rel_count);
+	if (pushed != pool->rel_count) {
+		shm_err("Unable to release %d buffers from channel %d\n",
+				pool->rel_count - pushed, chan_id);
+		ipc_stat_add(&get_chan_stats(instance, chan_id)->release_err,
+				(uint32_t)(pool->rel_count - pushed), true);
+
+		/* keep BDs that didn't fit in cache */
+		pool->rel_count -= pushed;
+		(void) memmove(&pool->rel_cache[0], &pool->rel_cache[pushed],
+				(size_t)pool->rel_count * sizeof(uint64_t));
+		return -ENOMEM;
 	}
 
-	return work;
+	pool->rel_count = 0;
+	return 0;
 }
 
 /**
- * ipc_buf_pool_init() - init buffer pool
+ * ipc_release_flush() - push cached released BDs of all channel pools
  * @instance:	instance id
- * @chan_id:	channel index
- * @pool_id:	pool index in channel
- * @local_shm:	local pool shared memory address
- * @remote_shm: remote pool shared memory address
- * @cfg:	channel configuration parameters
+ * @chan_id:	managed channel id
  *
- * To ensure freedom from interference when writing in shared memory, only one
- * IPC is allowed to write in a BD ring, so the IPC that pushes BDs in the
- * release ring at the end of an Rx operation must also initialize it. That's
- * why local IPC initializes bd_queue with BDs pointing to remote free buffers.
- * Since the shared memory configuration is symmetric and remote base address
- * is known, local IPC can compute the remote BD info.
+ * Return: 0 on success, error code otherwise
+ */
+static int ipc_release_flush(const uint8_t instance, int chan_id)
+{
+	struct ipc_managed_channel *chan =
+		&get_channel_priv(instance, chan_id)->ch.mng;
+	int err = 0;
+	int i;
+
+	for (i = 0; i < chan->num_pools; i++) {
+		if (ipc_release_flush_pool(instance, chan_id,
+					&chan->pools[i]) != 0)
+			err = -ENOMEM;
+	}
+
+	return err;
+}
+
+/**
+ * ipc_release_cache_add() - store BD of a released buffer in pool cache
+ * @instance:	instance id
+ * @chan_id:	managed channel id
+ * @pool_id:	pool index
+ * @buf_id:	buffer index in pool
  *
- * Return: 0 for success, error code otherwise
+ * The pool cache is flushed in release ring when full, or right away when no
+ * Rx pass of the channel is running: otherwise the cached buffers would wait
+ * for an Rx pass that remote can't trigger once it has no free buffer left.
+ * BDs that don't fit the release ring stay cached for the next flush, so once
+ * the BD is cached the buffer counts as released. Called with the release
+ * cache locked.
+ *
+ * Return: 0 on success, error code if the buffer was not released
  */
-static int ipc_buf_pool_init(const uint8_t instance, int chan_id, int pool_id,
-		uintptr_t local_shm, uintptr_t remote_shm,
-		const struct ipc_shm_pool_cfg *cfg)
+static int ipc_release_cache_add(const uint8_t instance, int chan_id,
+		int16_t pool_id, uint16_t buf_id)
 {
-	struct ipc_managed_channel *chan = get_managed_chan(instance, chan_id);
+	struct ipc_managed_channel *chan =
+		&get_channel_priv(instance, chan_id)->ch.mng;
 	struct ipc_shm_pool *pool = &chan->pools[pool_id];
-	struct ipc_shm_bd bd;
-	uint32_t queue_mem_size;
-	uint16_t i;
+	union ipc_shm_bd_elem elem;
+
+	elem.bd.pool_id = (uint8_t) pool_id;
+	elem.bd.flags = 0u;
+	elem.bd.buf_id = buf_id;
+	elem.bd.data_size = 0; /* reset size of written data in buffer */
+
+	/* cache left full by a failed flush (release ring full) */
+	if (pool->rel_count == IPC_SHM_RELEASE_CACHE_SIZE) {
+		(void) ipc_release_flush_pool(instance, chan_id, pool);
+		if (pool->rel_count == IPC_SHM_RELEASE_CACHE_SIZE) {
+			ipc_stat_add(&get_chan_stats(instance, chan_id)
+					->release_err, 1u, true);
+			return -ENOMEM;
+		}
+	}
+
+	pool->rel_cache[pool->rel_count] = elem.word;
+	pool->rel_count++;
+
+	shm_dbg("ch %d: pool %d: deferred release of buffer %d\n",
+			chan_id, pool_id, buf_id);
+
+	if ((pool->rel_count == IPC_SHM_RELEASE_CACHE_SIZE)
+			|| !chan->rel_in_rx)
+		(void) ipc_release_flush_pool(instance, chan_id, pool);
+
+	return 0;
+}
+
+/**
+ * ipc_release_bd() - return a received buffer to remote
+ * @instance:	instance id
+ * @chan_id:	managed channel id
+ * @pool_id:	pool index
+ * @buf_id:	buffer index in pool
+ *
+ * Used for buffers released by app and for received buffers the Rx handler
+ * doesn't hand to app. The buffer BD is pushed in pool release ring, or cached
+ * on IPC_SHM_CHAN_DEFER_RELEASE channels.
+ *
+ * Return: 0 on success, error code if the buffer was not released
+ */
+static int ipc_release_bd(const uint8_t instance, int chan_id,
+		int16_t pool_id, uint16_t buf_id)
+{
+	struct ipc_managed_channel *chan =
+		&get_channel_priv(instance, chan_id)->ch.mng;
+	union ipc_shm_bd_elem elem;
 	int err;
 
-	if (cfg->num_bufs > IPC_SHM_MAX_BUFS_PER_POOL) {
-		shm_err("Too many buffers configured in pool. "
-				"Increase IPC_SHM_MAX_BUFS_PER_POOL if needed\n");
-		return -EINVAL;
+	if ((chan->flags & IPC_SHM_CHAN_DEFER_RELEASE) != 0u) {
+		ipc_release_lock(chan);
+		err = ipc_release_cache_add(instance, chan_id, pool_id, buf_id);
+		ipc_release_unlock(chan);
+		return err;
 	}
 
-	pool->num_bufs = cfg->num_bufs;
-	pool->buf_size = cfg->buf_size;
+	elem.bd.pool_id = (uint8_t) pool_id;
+	elem.bd.flags = 0u;
+	elem.bd.buf_id = buf_id;
+	elem.bd.data_size = 0; /* reset size of written data in buffer */
+
+	/* push BD in release ring */
+	if (ipc_queue_push64(&chan->pools[pool_id].bd_queue, elem.word) != 0) {
+		shm_err("Unable to release buffer %d from pool %d from channel %d\n",
+				buf_id, pool_id, chan_id);
+		ipc_stat_add(&get_chan_stats(instance, chan_id)->release_err,
+				1u, true);
+		return -ENOMEM;
+	}
 
-	/* init pool bd_queue with push ring mapped at the start of local
-	 * pool shm and pop ring mapped at start of remote pool shm
+	shm_dbg("ch %d: pool %d: released buffer %d\n",
+			chan_id, pool_id, buf_id);
+	return 0;
+}
+
+/**
+ * ipc_umem_read_slot() - get latest snapshot of remote unmanaged memory
+ * @chan:	unmanaged channel configured with IPC_SHM_UMNG_SNAPSHOT
+ *
+ * The pair holding the latest snapshot is claimed before its slot is read, so
+ * the remote writer keeps off it until the next read.
+ *
+ * Return: address of latest complete snapshot
+ */
+static void *ipc_umem_read_slot(struct ipc_unmanaged_channel *chan)
+{
+	uint32_t pair, slot;
+
+	/* indexes written by remote are masked, so that corrupted control
+	 * words can't point outside of channel memory
 	 */
-	err = ipc_queue_init(&pool->bd_queue, pool->num_bufs,
-		(uint8_t)sizeof(struct ipc_shm_bd), local_shm, remote_shm);
-	if (err != 0)
-		return err;
+	pair = ipc_os_load_acquire(&chan->remote_slots->latest) & 1u;
+	ipc_os_store_release(&chan->local_slots->reading, pair);
+	ipc_os_mb();
+	slot = ipc_os_load_acquire(&chan->remote_slots->slot[pair]) & 1u;
 
-	/* init local/remote buffer pool addrs */
-	queue_mem_size = ipc_queue_mem_size(&pool->bd_queue);
+	return get_umem_slot(chan, chan->remote_slots, pair, slot);
+}
 
-	/* init actual local buffer pool addr */
-	pool->local_pool_addr = local_shm + queue_mem_size;
+/**
+ * ipc_large_rx() - reassemble a received large message fragment
+ * @instance:	instance id
+ * @chan_id:	channel id
+ * @bd:		received BD of the fragment (indexes already validated)
+ * @buf:	buffer holding the fragment
+ *
+ * The fragment buffer is released after its data is copied, in the locked
+ * release cache on deferred release channels, otherwise in the release ring,
+ * which is multi-producer on IPC_SHM_CHAN_LARGE channels. The app
+ * Rx callback is called with the reassembly buffer after the last fragment.
+ * Messages that don't fit the reassembly buffer, or with a fragment larger
+ * than its buffer, are dropped and counted in rx_dropped instead of rx_msgs,
+ * as well as all messages of channels without reassembly buffer.
+ */
+static void ipc_large_rx(const uint8_t instance, int chan_id,
+		const struct ipc_shm_bd *bd, const void *buf)
+{
+	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
+	struct ipc_managed_channel *mchan = &chan->ch.mng;
+	struct ipc_managed_rx_state *rx = mchan->rx;
+	uint32_t size = bd->data_size;
+
+	/* fragment size is written by remote, don't trust it */
+	if (!rx->large_err && (mchan->large_buf != NULL)
+			&& (size <= mchan->pools[bd->pool_id].buf_size)
+			&& (size <= (rx->large_size - rx->large_len))) {
+		(void) memcpy(&mchan->large_buf[rx->large_len], buf, size);
+		rx->large_len += size;
+	} else {
+		rx->large_err = true;
+	}
 
-	/* init actual remote buffer pool addr */
-	pool->remote_pool_addr = remote_shm + queue_mem_size;
+	(void) ipc_release_bd(instance, chan_id, bd->pool_id, bd->buf_id);
 
-	pool->shm_size = queue_mem_size + (cfg->buf_size * cfg->num_bufs);
+	if ((bd->flags & IPC_SHM_BD_MORE) != 0u)
+		return;
 
-	/* check if pool fits into shared memory */
-	if ((local_shm + pool->shm_size)
-			> (ipc_os_get_local_shm(instance)
-				+ ipc_shm_priv_data[instance].shm_size)) {
-		shm_err("Not enough shared memory for pool %d from channel %d\n",
-				pool_id, chan_id);
-		return -ENOMEM;
+	if (mchan->large_buf == NULL) {
+		shm_err("Large message received on channel %d without reassembly buffer, dropped\n",
+				chan_id);
+		ipc_stat_add(&chan->stats.rx_dropped, 1u, false);
+	} else if (rx->large_err) {
+		shm_err("Large message of channel %d exceeds %u bytes or has invalid fragment size, dropped\n",
+				chan_id, rx->large_size);
+		ipc_stat_add(&chan->stats.rx_dropped, 1u, false);
+	} else {
+		mchan->rx_cb(mchan->cb_arg, instance, chan->id,
+				mchan->large_buf, rx->large_len);
+		ipc_stat_add(&chan->stats.rx_msgs, 1u, false);
+		ipc_stat_add(&chan->stats.rx_bytes, rx->large_len, false);
 	}
 
-	/* populate bd_queue with free BDs from remote pool */
-	for (i = 0; i < pool->num_bufs; i++) {
-		bd.pool_id = (int16_t) pool_id;
-		bd.buf_id = i;
-		bd.data_size = 0;
+	rx->large_len = 0;
+	rx->large_err = false;
+}
 
-		err = ipc_queue_push(&pool->bd_queue, &bd);
-		if (err != 0) {
-			shm_err("Unable to init queue with free buffer descriptors "
-					"for pool %d of channel %d\n",
-					pool_id, chan_id);
-			return err;
+/**
+ * ipc_channel_rx() - handle Rx for a single channel
+ * @instance:	instance id
+ * @chan_id:	channel id
+ * @budget:	available work budget (number of messages to be processed)
+ *
+ * Return:	work done
+ */
+static int ipc_channel_rx(const uint8_t instance, int chan_id, int budget)
+{
+	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
+	struct ipc_managed_channel *mchan = &chan->ch.mng;
+	struct ipc_unmanaged_channel *uchan = &chan->ch.umng;
+	struct ipc_inline_channel *ichan = &chan->ch.inl;
+	struct ipc_managed_rx_state *rx;
+	struct ipc_shm_pool *pool;
+	union ipc_shm_bd_elem bds[IPC_SHM_RX_BATCH];
+	uintptr_t buf_addr;
+	uint32_t remote_tx_count;
+	const void *msg;
+	uint32_t msg_size;
+	uint64_t rx_bytes = 0;
+	uint64_t rx_msgs = 0;
+	bool more;
+	int count, i;
+	int work = 0;
+
+	/* unmanaged channels: call Rx callback if channel Tx counter changed */
+	if (chan->type == IPC_SHM_UNMANAGED) {
+		if (0 == ipc_chan_integrity_policy(instance, chan_id)) {
+			remote_tx_count = ipc_os_load_acquire(
+					&uchan->remote_mem->tx_count);
+
+			/* call Rx cb if remote Tx counter changed */
+			if (remote_tx_count != uchan->remote_tx_count) {
+
+				/* save new remote Tx counter */
+				uchan->remote_tx_count = remote_tx_count;
+				ipc_stat_add(&chan->stats.rx_msgs, 1u, false);
+				ipc_stat_add(&chan->stats.rx_bytes, uchan->size,
+						false);
+
+				if (uchan->local_slots != NULL) {
+					uchan->rx_cb(uchan->cb_arg, instance,
+						chan->id,
+						ipc_umem_read_slot(uchan));
+					return budget;
+				}
+
+				uchan->rx_cb(uchan->cb_arg, instance, chan->id,
+						(void *)uchan->remote_mem->mem);
+
+				return budget;
+			}
 		}
+		return 0;
 	}
 
-	shm_dbg("ipc shm pool %d of chan %d initialized\n", pool_id, chan_id);
-	return 0;
+	/* inline channels: hand messages to app in place, one at a time */
+	if (chan->type == IPC_SHM_INLINE) {
+		if (ipc_chan_integrity_policy(instance, chan_id) != 0)
+			return 0;
+
+		while ((work < budget)
+				&& (ipc_queue_msg_peek(&ichan->queue, &msg,
+					&msg_size) == 0)) {
+			ichan->rx_cb(ichan->cb_arg, instance, chan->id,
+					(void *)msg, msg_size);
+
+			/* release ring space after app is done with message */
+			(void) ipc_queue_msg_consume(&ichan->queue);
+			rx_bytes += msg_size;
+			work++;
+		}
+
+		ipc_stat_add(&chan->stats.rx_msgs, (uint64_t)work, false);
+		ipc_stat_add(&chan->stats.rx_bytes, rx_bytes, false);
+		return work;
+	}
+
+	/* releases made during this pass stay cached until it ends */
+	if ((mchan->flags & IPC_SHM_CHAN_DEFER_RELEASE) != 0u) {
+		ipc_release_lock(mchan);
+		mchan->rel_in_rx = true;
+		ipc_release_unlock(mchan);
+	}
+
+	/* managed channels: process incoming BDs in the limit of budget */
+	while (work < budget) {
+		/* pop a burst of BDs to publish the read index only once */
+		count = ipc_queue_pop64_n(&mchan->bd_queue, &bds[0].word,
+				(uint32_t)ipc_min(budget - work,
+					IPC_SHM_RX_BATCH));
+		if (count <= 0) {
+			break;
+		}
+
+		for (i = 0; i < count; i++) {
+			/* BD is written by remote, don't trust its indexes */
+			if ((bds[i].bd.pool_id >= mchan->num_pools)
+					|| (bds[i].bd.buf_id >= mchan->pools[
+						bds[i].bd.pool_id].num_bufs)) {
+				shm_err("Invalid buffer %u of pool %u received on channel %d, dropped\n",
+						bds[i].bd.buf_id,
+						bds[i].bd.pool_id, chan_id);
+				ipc_stat_add(&chan->stats.rx_dropped, 1u,
+						false);
+				continue;
+			}
+
+			/* flags of options the channel didn't negotiate: the
+			 * BD is corrupted (remote queue sentinel matched), so
+			 * like BDs with invalid indexes it is not released
+			 */
+			if ((bds[i].bd.flags & ~mchan->bd_flags) != 0u) {
+				shm_err("Buffer with flags 0x%x received on channel %d, dropped\n",
+						bds[i].bd.flags, chan_id);
+				ipc_stat_add(&chan->stats.rx_dropped, 1u,
+						false);
+				continue;
+			}
+
+			pool = &mchan->pools[bds[i].bd.pool_id];
+			buf_addr = pool->remote_pool_addr +
+				get_buf_offset(pool, bds[i].bd.buf_id);
+			more = ((bds[i].bd.flags & IPC_SHM_BD_MORE) != 0u);
+
+			/* message latency is measured on its last buffer */
+			if ((pool->remote_ts != NULL) && !more)
+				ipc_latency_record(mchan->rx,
+					pool->remote_ts[bds[i].bd.buf_id],
+					ipc_os_get_timestamp());
+
+			/* large message fragments are copied, buffer released */
+			if ((bds[i].bd.flags & IPC_SHM_BD_LARGE) != 0u) {
+				ipc_large_rx(instance, chan_id, &bds[i].bd,
+						(void *)buf_addr);
+				continue;
+			}
+			rx_bytes += bds[i].bd.data_size;
+
+			/* single buffer messages, or chained buffers handed
+			 * one by one when no scatter-gather callback is set
+			 */
+			if ((mchan->rx_sg_cb == NULL)
+					|| (!more && (mchan->rx->sg_count == 0))) {
+				mchan->rx_cb(mchan->cb_arg, instance, chan->id,
+						(void *)buf_addr,
+						bds[i].bd.data_size);
+				if (!more)
+					rx_msgs++;
+				continue;
+			}
+
+			rx = mchan->rx;
+			rx->sg[rx->sg_count].buf = (void *)buf_addr;
+			rx->sg[rx->sg_count].size = bds[i].bd.data_size;
+			rx->sg_count++;
+			if (more && (rx->sg_count < IPC_SHM_MAX_SG_BUFS))
+				continue;
+
+			if (more)
+				shm_err("Message of channel %d exceeds %d buffers, handing it in parts\n",
+						chan_id, IPC_SHM_MAX_SG_BUFS);
+
+			mchan->rx_sg_cb(mchan->cb_arg, instance, chan->id,
+					rx->sg, rx->sg_count);
+			rx->sg_count = 0;
+			if (!more)
+				rx_msgs++;
+		}
+		work += count;
+	}
+
+	ipc_stat_add(&chan->stats.rx_msgs, rx_msgs, false);
+	ipc_stat_add(&chan->stats.rx_bytes, rx_bytes, false);
+
+	/* return buffers released by app during this pass to remote */
+	if ((mchan->flags & IPC_SHM_CHAN_DEFER_RELEASE) != 0u) {
+		ipc_release_lock(mchan);
+		(void) ipc_release_flush(instance, chan_id);
+		mchan->rel_in_rx = false;
+		ipc_release_unlock(mchan);
+	}
+
+	return work;
 }
 
-static int managed_channel_init(const uint8_t instance, int chan_id,
-		uintptr_t local_shm, uintptr_t remote_shm,
-		const struct ipc_shm_managed_cfg *cfg)
+/**
+ * ipc_instance_is_free() - determine if the instance is used or not
+ * @instance:	instance id
+ *
+ * This function return the state of instance.
+ *
+ * Return: IPC_SHM_INSTANCE_FREE if instance is free,
+ *     IPC_SHM_INSTANCE_USED otherwise or
+ *     IPC_SHM_INSTANCE_ERROR if there is errors
+ */
+static uint8_t ipc_instance_is_free(const uint8_t instance)
 {
-	struct ipc_managed_channel *chan = get_managed_chan(instance, chan_id);
-	const struct ipc_shm_pool_cfg *pool_cfg;
-	uintptr_t local_pool_shm;
-	uintptr_t remote_pool_shm;
-	uint32_t queue_mem_size;
-	uint32_t prev_buf_size = 0;
-	uint32_t total_bufs = 0;
-	int err, i;
+	if (instance >= IPC_SHM_MAX_INSTANCES)
+		return IPC_SHM_INSTANCE_ERROR;
+
+	if (ipc_shm_priv_data[instance].global == NULL)
+		return IPC_SHM_INSTANCE_FREE;
+	if (ipc_shm_priv_data[instance].global->state == IPC_SHM_STATE_CLEAR)
+		return IPC_SHM_INSTANCE_FREE;
+
+	return IPC_SHM_INSTANCE_USED;
+}
+
+/**
+ * ipc_shm_rx_level() - handle Rx for channels with same priority
+ * @instance:	instance id
+ * @order:	ids of channels with same priority
+ * @num_chans:	number of channels with same priority
+ * @sel:	channels to handle or NULL for all
+ * @budget:	available work budget (number of messages to be processed)
+ *
+ * This function handles the channels using a weighted fair algorithm: each
+ * round, every channel gets a budget share proportional to its weight, so no
+ * channel is starving. Drained channels are skipped in next rounds.
+ *
+ * Return:	work done
+ */
+static int ipc_shm_rx_level(const uint8_t instance, const uint16_t *order,
+		int num_chans, const struct ipc_chan_sel *sel, int budget)
+{
+	struct ipc_shm_channel *chan;
+	uint32_t total_weight;
+	int chan_budget, chan_work;
+	int round_budget;
+	int work = 0;
+	int i;
+
+	while (work < budget) {
+		/* sum weights of channels that still have work */
+		total_weight = 0;
+		for (i = 0; i < num_chans; i++) {
+			chan = get_channel_priv(instance, order[i]);
+			if (ipc_chan_selected(sel, order[i])
+					&& chan->rx_pending)
+				total_weight += chan->weight;
+		}
+		if (total_weight == 0u)
+			break;
+
+		/* shares of a round are taken from the budget left at its start */
+		round_budget = budget - work;
+		for (i = 0; (i < num_chans) && (work < budget); i++) {
+			chan = get_channel_priv(instance, order[i]);
+			if (!ipc_chan_selected(sel, order[i])
+					|| !chan->rx_pending)
+				continue;
+
+			chan_budget = ipc_max((int)(((uint32_t)round_budget
+					* chan->weight) / total_weight), 1);
+			chan_budget = ipc_min(chan_budget, budget - work);
+			chan_work = ipc_channel_rx(instance, order[i],
+					chan_budget);
+			work += chan_work;
+
+			if (chan_work < chan_budget)
+				chan->rx_pending = false;
+		}
+	}
+
+	return work;
+}
+
+/**
+ * ipc_shm_rx_channels() - handle Rx for all or selected channels
+ * @instance:	instance id
+ * @sel:	channels to handle or NULL for all
+ * @budget:	available work budget (number of messages to be processed)
+ *
+ * Channels are handled in descending priority order: a priority level is
+ * drained before channels with lower priority are handled. Channels with
+ * same priority share the budget according to their weights.
+ *
+ * Only the Rx state of selected channels is changed, so that channels selected
+ * by disjoint masks can be handled concurrently.
+ *
+ * Return:	work done
+ */
+static int ipc_shm_rx_channels(const uint8_t instance,
+		const struct ipc_chan_sel *sel, int budget)
+{
+	const struct ipc_shm_priv *priv = &ipc_shm_priv_data[instance];
+	uint8_t priority;
+	int first, last;
+	int work = 0;
+
+	for (first = 0; first < priv->num_channels; first++) {
+		if (ipc_chan_selected(sel, first))
+			priv->channels[first].rx_pending = true;
+	}
+
+	for (first = 0; (first < priv->num_channels) && (work < budget);
+			first = last) {
+		/* find channels with same priority */
+		priority = priv->channels[priv->rx_order[first]].priority;
+		for (last = first + 1; last < priv->num_channels; last++) {
+			if (priv->channels[priv->rx_order[last]].priority
+					!= priority)
+				break;
+		}
+
+		work += ipc_shm_rx_level(instance, &priv->rx_order[first],
+				last - first, sel, budget - work);
+	}
+
+	return work;
+}
+
+/**
+ * ipc_shm_rx_pending() - check if any channel has received data to process
+ * @instance:	instance id
+ * @sel:	channels to check or NULL for all
+ *
+ * Return:	true if there is at least one message to process
+ */
+static bool ipc_shm_rx_pending(const uint8_t instance,
+		const struct ipc_chan_sel *sel)
+{
+	struct ipc_shm_channel *chan;
+	int i;
+
+	for (i = 0; i < ipc_shm_priv_data[instance].num_channels; i++) {
+		if (!ipc_chan_selected(sel, i))
+			continue;
+
+		chan = get_channel_priv(instance, i);
+
+		if (chan->type == IPC_SHM_UNMANAGED) {
+			if (ipc_os_load_acquire(&chan->ch.umng.remote_mem->tx_count)
+					!= chan->ch.umng.remote_tx_count)
+				return true;
+		} else if (chan->type == IPC_SHM_INLINE) {
+			if (ipc_queue_count(&chan->ch.inl.queue) != 0u)
+				return true;
+		} else {
+			if (ipc_queue_count(&chan->ch.mng.bd_queue) != 0u)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * count a local Rx run in or out of the private rx_active counter and publish
+ * whether runs are active to remote: concurrent polling threads each count
+ * their own run, so remote doesn't notify while at least one of them is
+ * processing channels. Shared memory may be mapped as device memory, where
+ * atomic read-modify-write is not supported, so it is only stored to. The
+ * flag is stored again if the counter changed meanwhile, so that the last
+ * store matches the final count.
+ */
+static inline void ipc_rx_active_add(struct ipc_shm_priv *priv,
+		uint32_t delta)
+{
+	uint32_t active;
+
+	do {
+		active = ipc_os_load_acquire(&priv->rx_active);
+	} while (!ipc_os_cas(&priv->rx_active, active, active + delta));
+
+	do {
+		active = ipc_os_load_acquire(&priv->rx_active);
+		ipc_os_store_release(&priv->global->rx_active,
+				(active != 0u) ? 1u : 0u);
+
+		/* pairs with barrier between publish and flag check in
+		 * remote Tx
+		 */
+		ipc_os_mb();
+	} while ((ipc_os_load_acquire(&priv->rx_active) != 0u)
+			!= (active != 0u));
+}
+
+/**
+ * ipc_shm_rx_run() - handle Rx for all or selected channels
+ * @instance:	instance id
+ * @sel:	channels to handle or NULL for all
+ * @budget:	available work budget (number of messages to be processed)
+ *
+ * With background integrity policy, the selected channels are checked once
+ * per run.
+ *
+ * With IPC_SHM_NOTIFY_SUPPRESS, the local rx_active flag tells remote that
+ * channels are being processed and it doesn't need to notify new messages.
+ * After the run is counted out, the selected channels are checked again, so
+ * that a message published by remote just before seeing the flag cleared is
+ * not missed.
+ *
+ * Return:	work done
+ */
+static int ipc_shm_rx_run(const uint8_t instance,
+		const struct ipc_chan_sel *sel, int budget)
+{
+	struct ipc_shm_priv *priv = &ipc_shm_priv_data[instance];
+	int work, pass;
+
+	if (ipc_shm_priv_data[instance].integrity_policy
+			== IPC_SHM_INTEGRITY_BACKGROUND)
+		(void) ipc_check_selected_integrity(instance, sel);
+
+	if ((ipc_shm_priv_data[instance].flags & IPC_SHM_NOTIFY_SUPPRESS)
+			== 0u)
+		return ipc_shm_rx_channels(instance, sel, budget);
+
+	ipc_rx_active_add(priv, 1u);
+
+	work = ipc_shm_rx_channels(instance, sel, budget);
+	while (work < budget) {
+		/* count run out before checking for messages */
+		ipc_rx_active_add(priv, (uint32_t)-1);
+		if (!ipc_shm_rx_pending(instance, sel))
+			return work;
+
+		ipc_rx_active_add(priv, 1u);
+		pass = ipc_shm_rx_channels(instance, sel, budget - work);
+
+		/* pending data no channel can consume (e.g. channel in error) */
+		if (pass == 0)
+			break;
+		work += pass;
+	}
+
+	/* budget exhausted (Rx handler is called again by OS layer) or no
+	 * progress made
+	 */
+	ipc_rx_active_add(priv, (uint32_t)-1);
+
+	return work;
+}
+
+/**
+ * ipc_shm_rx() - shm Rx handler, called from softirq
+ * @instance:	instance id
+ * @budget:	available work budget (number of messages to be processed)
+ *
+ * Return:	work done
+ */
+static int ipc_shm_rx(const uint8_t instance, int budget)
+{
+	return ipc_shm_rx_run(instance, NULL, budget);
+}
+
+/* hot descriptor size of a managed channel: pools, ranges, size classes */
+static inline size_t ipc_mchan_hot_size(int num_pools)
+{
+	return IPC_SHM_DESC_ALIGN((size_t)num_pools
+			* (sizeof(struct ipc_shm_pool)
+				+ (2u * sizeof(struct ipc_shm_pool_range)))
+			+ (IPC_SHM_SIZE_CLASSES * sizeof(uint16_t)));
+}
+
+/* cold descriptor size of a managed channel: Rx state, release caches */
+static inline size_t ipc_mchan_cold_size(int num_pools)
+{
+	return IPC_SHM_DESC_ALIGN(sizeof(struct ipc_managed_rx_state))
+		+ IPC_SHM_DESC_ALIGN((size_t)num_pools
+			* IPC_SHM_RELEASE_CACHE_SIZE * sizeof(uint64_t));
+}
+
+/**
+ * ipc_shm_desc_area_size() - size of hot or cold descriptors of an instance
+ * @cfg:	instance configuration
+ * @cold:	size of cold descriptors instead of hot ones
+ *
+ * Invalid pool configurations are not counted, they are rejected by channel
+ * init before any pool descriptor is allocated.
+ *
+ * Return: descriptor area size
+ */
+static size_t ipc_shm_desc_area_size(const struct ipc_shm_cfg *cfg, bool cold)
+{
+	const struct ipc_shm_managed_cfg *mcfg;
+	size_t size = 0;
+	int i;
+
+	if (!cold)
+		size = IPC_SHM_DESC_ALIGN((size_t)cfg->num_channels
+				* sizeof(struct ipc_shm_channel))
+			+ IPC_SHM_DESC_ALIGN((size_t)cfg->num_channels
+				* sizeof(uint16_t));
+
+	for (i = 0; (cfg->channels != NULL) && (i < cfg->num_channels); i++) {
+		mcfg = &cfg->channels[i].ch.managed;
+		if ((cfg->channels[i].type != IPC_SHM_MANAGED)
+				|| (mcfg->num_pools < 1)
+				|| (mcfg->num_pools > IPC_SHM_MAX_POOLS))
+			continue;
+
+		size += cold ? ipc_mchan_cold_size(mcfg->num_pools)
+			: ipc_mchan_hot_size(mcfg->num_pools);
+	}
+
+	return size;
+}
+
+/* size of channel and pool descriptors of an instance */
+static inline size_t ipc_shm_desc_size(const struct ipc_shm_cfg *cfg)
+{
+	return ipc_shm_desc_area_size(cfg, false)
+		+ ipc_shm_desc_area_size(cfg, true);
+}
+
+/**
+ * ipc_shm_desc_alloc() - assign zeroed descriptor memory
+ * @instance:	instance id
+ * @size:	size of descriptors
+ * @cold:	descriptors used only by rare paths
+ *
+ * Hot descriptors are assigned from the start of descriptor memory and cold
+ * ones after all hot descriptors, so that cold data doesn't split hot data of
+ * consecutive channels.
+ *
+ * Return: descriptor address, NULL if instance descriptor memory is exhausted
+ */
+static void *ipc_shm_desc_alloc(const uint8_t instance, size_t size,
+		bool cold)
+{
+	struct ipc_shm_priv *priv = &ipc_shm_priv_data[instance];
+	size_t *used = cold ? &priv->desc_cold_used : &priv->desc_used;
+	size_t end = cold ? priv->desc_size : priv->desc_hot_size;
+	size_t start = cold ? priv->desc_hot_size : 0u;
+	void *desc;
+
+	size = IPC_SHM_DESC_ALIGN(size);
+	if (size > (end - start - *used)) {
+		shm_err("Not enough descriptor memory\n");
+		return NULL;
+	}
+
+	desc = (uint8_t *)priv->desc_mem + start + *used;
+	*used += size;
+
+	return desc;
+}
+
+/*
+ * release descriptor memory of an instance if allocated by driver, together
+ * with the reassembly buffers allocated by driver
+ */
+static void ipc_shm_desc_free(const uint8_t instance)
+{
+	struct ipc_shm_priv *priv = &ipc_shm_priv_data[instance];
+	struct ipc_managed_channel *mchan;
+	int i;
+
+	for (i = 0; (priv->channels != NULL) && (i < priv->num_channels); i++) {
+		mchan = &priv->channels[i].ch.mng;
+		if ((priv->channels[i].type == IPC_SHM_MANAGED)
+				&& (mchan->rx != NULL) && mchan->rx->large_owned) {
+			ipc_os_buf_free(mchan->large_buf);
+			mchan->large_buf = NULL;
+			mchan->rx->large_owned = false;
+		}
+	}
+
+	if (priv->desc_owned)
+		ipc_os_mem_free(priv->desc_mem);
+
+	priv->desc_mem = NULL;
+	priv->desc_size = 0;
+	priv->desc_hot_size = 0;
+	priv->desc_used = 0;
+	priv->desc_cold_used = 0;
+	priv->desc_owned = false;
+	priv->channels = NULL;
+	priv->rx_order = NULL;
+}
+
+/**
+ * ipc_shm_desc_init() - get descriptor memory of an instance
+ * @instance:	instance id
+ * @cfg:	instance configuration
+ *
+ * Descriptors are assigned from the arena provided by app, if any, otherwise
+ * they are allocated by the OS layer.
+ *
+ * Return: 0 for success, error code otherwise
+ */
+static int ipc_shm_desc_init(const uint8_t instance,
+		const struct ipc_shm_cfg *cfg)
+{
+	struct ipc_shm_priv *priv = &ipc_shm_priv_data[instance];
+	size_t size = ipc_shm_desc_size(cfg);
+
+	if (cfg->arena != NULL) {
+		if ((cfg->arena_size < size)
+				|| (((uintptr_t)cfg->arena % 8u) != 0u)) {
+			shm_err("Arena must be 8 byte aligned and at least %zu bytes\n",
+					size);
+			return -EINVAL;
+		}
+		priv->desc_mem = cfg->arena;
+		priv->desc_owned = false;
+	} else {
+		priv->desc_mem = ipc_os_mem_alloc(size);
+		if (priv->desc_mem == NULL)
+			return -ENOMEM;
+		priv->desc_owned = true;
+	}
+
+	(void) memset(priv->desc_mem, 0, size);
+	priv->desc_size = size;
+	priv->desc_hot_size = ipc_shm_desc_area_size(cfg, false);
+	priv->desc_used = 0;
+	priv->desc_cold_used = 0;
+
+	priv->channels = ipc_shm_desc_alloc(instance,
+			(size_t)cfg->num_channels * sizeof(struct ipc_shm_channel),
+			false);
+	priv->rx_order = ipc_shm_desc_alloc(instance,
+			(size_t)cfg->num_channels * sizeof(uint16_t), false);
+
+	return 0;
+}
+
+/**
+ * ipc_buf_pool_init() - init buffer pool
+ * @instance:	instance id
+ * @chan_id:	channel index
+ * @pool_id:	pool index in channel
+ * @local_shm:	local pool shared memory address
+ * @remote_shm: remote pool shared memory address
+ * @cfg:	channel configuration parameters
+ *
+ * To ensure freedom from interference when writing in shared memory, only one
+ * IPC is allowed to write in a BD ring, so the IPC that pushes BDs in the
+ * release ring at the end of an Rx operation must also initialize it. That's
+ * why local IPC initializes bd_queue with BDs pointing to remote free buffers.
+ * Since the shared memory configuration is symmetric and remote base address
+ * is known, local IPC can compute the remote BD info.
+ *
+ * Return: 0 for success, error code otherwise
+ */
+static int ipc_buf_pool_init(const uint8_t instance, int chan_id, int pool_id,
+		uintptr_t local_shm, uintptr_t remote_shm,
+		const struct ipc_shm_pool_cfg *cfg)
+{
+	struct ipc_managed_channel *chan = get_managed_chan(instance, chan_id);
+	struct ipc_shm_pool *pool = &chan->pools[pool_id];
+	struct ipc_shm_bd bd;
+	uint32_t queue_mem_size;
+	uint32_t pool_size;
+	uint8_t queue_flags;
+	uint16_t i;
+	int err;
+
+	if (cfg->num_bufs > IPC_SHM_MAX_BUFS_PER_POOL) {
+		shm_err("Too many buffers configured in pool. "
+				"Increase IPC_SHM_MAX_BUFS_PER_POOL if needed\n");
+		return -EINVAL;
+	}
+
+	pool->num_bufs = cfg->num_bufs;
+	pool->rel_count = 0;
+	pool->buf_size = cfg->buf_size;
+
+	/* index power-of-two sized buffers with shifts instead of divisions */
+	pool->buf_shift = IPC_SHM_BUF_SHIFT_NONE;
+	if ((cfg->buf_size != 0u)
+			&& ((cfg->buf_size & (cfg->buf_size - 1u)) == 0u)) {
+		pool->buf_shift = 0u;
+		while ((1u << pool->buf_shift) != cfg->buf_size)
+			pool->buf_shift++;
+	}
+
+	/* the Rx handler releases large message fragments (reassembled or
+	 * dropped) while app threads release other buffers, so the release ring
+	 * has two local producers, unless releases are deferred (pushed with
+	 * the release cache locked)
+	 */
+	queue_flags = ipc_shm_priv_data[instance].queue_flags
+		| (chan->queue_flags & IPC_QUEUE_MC);
+	if (((chan->flags & IPC_SHM_CHAN_LARGE) != 0u)
+			&& ((chan->flags & IPC_SHM_CHAN_DEFER_RELEASE) == 0u))
+		queue_flags |= IPC_QUEUE_MP;
+
+	/* init pool bd_queue with push ring mapped at the start of local
+	 * pool shm and pop ring mapped at start of remote pool shm
+	 */
+	err = ipc_queue_init(&pool->bd_queue, pool->num_bufs,
+		(uint8_t)sizeof(struct ipc_shm_bd), queue_flags,
+		local_shm, remote_shm);
+	if (err != 0)
+		return err;
+	if (chan->bd_flags != 0u)
+		ipc_queue_set_format(&pool->bd_queue, IPC_SHM_BD_FORMAT);
+
+	/* init local/remote buffer pool addrs */
+	queue_mem_size = ipc_queue_mem_size(&pool->bd_queue);
+
+	/* init actual local buffer pool addr */
+	pool->local_pool_addr = local_shm + queue_mem_size;
+
+	/* init actual remote buffer pool addr */
+	pool->remote_pool_addr = remote_shm + queue_mem_size;
+
+	/* init buffer address ranges used to find the pool of a buffer */
+	chan->local_range[pool_id].start = pool->local_pool_addr;
+	chan->local_range[pool_id].end = pool->local_pool_addr
+		+ ((uintptr_t)cfg->buf_size * cfg->num_bufs);
+	chan->remote_range[pool_id].start = pool->remote_pool_addr;
+	chan->remote_range[pool_id].end = pool->remote_pool_addr
+		+ ((uintptr_t)cfg->buf_size * cfg->num_bufs);
+
+	pool_size = queue_mem_size + (cfg->buf_size * cfg->num_bufs);
+
+	/* map 8-byte aligned buffer timestamps after pool buffers */
+	pool->local_ts = NULL;
+	pool->remote_ts = NULL;
+	if ((chan->flags & IPC_SHM_CHAN_TIMESTAMP) != 0u) {
+		pool_size = (pool_size + (uint32_t)sizeof(uint64_t) - 1u)
+			& ~((uint32_t)sizeof(uint64_t) - 1u);
+		pool->local_ts = (uint64_t *)(local_shm + pool_size);
+		pool->remote_ts = (uint64_t *)(remote_shm + pool_size);
+		pool_size += (uint32_t)sizeof(uint64_t) * cfg->num_bufs;
+	}
+
+	pool->shm_size = get_layout_size(instance, pool_size);
+
+	/* check if pool fits into shared memory */
+	if ((local_shm + pool->shm_size)
+			> (ipc_os_get_local_shm(instance)
+				+ ipc_shm_priv_data[instance].shm_size)) {
+		shm_err("Not enough shared memory for pool %d from channel %d\n",
+				pool_id, chan_id);
+		return -ENOMEM;
+	}
+
+	/* populate bd_queue with free BDs from remote pool */
+	for (i = 0; i < pool->num_bufs; i++) {
+		bd.pool_id = (uint8_t) pool_id;
+		bd.flags = 0u;
+		bd.buf_id = i;
+		bd.data_size = 0;
+
+		err = ipc_queue_push(&pool->bd_queue, &bd);
+		if (err != 0) {
+			shm_err("Unable to init queue with free buffer descriptors "
+					"for pool %d of channel %d\n",
+					pool_id, chan_id);
+			return err;
+		}
+	}
+
+	shm_dbg("ipc shm pool %d of chan %d initialized\n", pool_id, chan_id);
+	return 0;
+}
+
+static int managed_channel_init(const uint8_t instance, int chan_id,
+		uintptr_t local_shm, uintptr_t remote_shm,
+		const struct ipc_shm_managed_cfg *cfg)
+{
+	struct ipc_managed_channel *chan = get_managed_chan(instance, chan_id);
+	const struct ipc_shm_pool_cfg *pool_cfg;
+	uintptr_t local_pool_shm;
+	uintptr_t remote_pool_shm;
+	uint32_t queue_mem_size;
+	uint32_t prev_buf_size = 0;
+	uint32_t total_bufs = 0;
+	uint32_t min_size;
+	uint64_t *rel_cache;
+	int err, i, pool_id;
+
+	if (cfg->rx_cb == NULL) {
+		shm_err("Receive callback not specified\n");
+		return -EINVAL;
+	}
+
+	if (cfg->pools == NULL) {
+		shm_err("NULL buffer pool configuration argument\n");
+		return -EINVAL;
+	}
+
+	if ((cfg->num_pools < 1) ||
+		(cfg->num_pools > IPC_SHM_MAX_POOLS)) {
+		shm_err("Number of pools must be between 1 and %d\n",
+				IPC_SHM_MAX_POOLS);
+		return -EINVAL;
+	}
+
+	/* allocate pool descriptors followed by their address range tables
+	 * and the size class table, then the Rx state followed by the release
+	 * caches in the cold descriptor area
+	 */
+	chan->pools = ipc_shm_desc_alloc(instance,
+			ipc_mchan_hot_size(cfg->num_pools), false);
+	if (chan->pools == NULL)
+		return -ENOMEM;
+	chan->local_range = (struct ipc_shm_pool_range *)
+		&chan->pools[cfg->num_pools];
+	chan->remote_range = &chan->local_range[cfg->num_pools];
+	chan->size_class = (uint16_t *)&chan->remote_range[cfg->num_pools];
+
+	chan->rx = ipc_shm_desc_alloc(instance,
+			ipc_mchan_cold_size(cfg->num_pools), true);
+	if (chan->rx == NULL)
+		return -ENOMEM;
+	rel_cache = (uint64_t *)((uintptr_t)chan->rx
+			+ IPC_SHM_DESC_ALIGN(sizeof(struct ipc_managed_rx_state)));
+	for (i = 0; i < cfg->num_pools; i++)
+		chan->pools[i].rel_cache =
+			&rel_cache[i * IPC_SHM_RELEASE_CACHE_SIZE];
+
+	if (((cfg->rx_large_buf != NULL) || (cfg->rx_large_size > 0u))
+			&& ((cfg->flags & IPC_SHM_CHAN_LARGE) == 0u)) {
+		shm_err("Reassembly buffer of channel %d requires IPC_SHM_CHAN_LARGE\n",
+				chan_id);
+		return -EINVAL;
+	}
+
+	/* use app reassembly buffer or allocate one apart from descriptors,
+	 * except for instances using an app arena (no dynamic allocation)
+	 */
+	chan->large_buf = cfg->rx_large_buf;
+	chan->rx->large_size = cfg->rx_large_size;
+	chan->rx->large_owned = false;
+	if ((chan->large_buf == NULL) && (chan->rx->large_size > 0u)) {
+		if (!ipc_shm_priv_data[instance].desc_owned) {
+			shm_err("Reassembly buffer of channel %d must be provided with arena\n",
+					chan_id);
+			return -EINVAL;
+		}
+		chan->large_buf = ipc_os_buf_alloc(chan->rx->large_size);
+		if (chan->large_buf == NULL)
+			return -ENOMEM;
+		chan->rx->large_owned = true;
+	}
+	if (chan->rx->large_size == 0u)
+		chan->large_buf = NULL;
+	chan->rx->large_len = 0;
+	chan->rx->large_err = false;
+
+	/* save managed channel parameters */
+	chan->rx_cb = cfg->rx_cb;
+	chan->rx_sg_cb = cfg->rx_sg_cb;
+	chan->cb_arg = cfg->cb_arg;
+	chan->num_pools = cfg->num_pools;
+	chan->rx->sg_count = 0;
+	chan->rel_lock = 0u;
+	chan->rel_in_rx = false;
+	chan->flags = cfg->flags;
+
+	/* concurrent producers push BDs in channel queue and pop free BDs
+	 * from pools, Rx side stays single consumer/producer
+	 */
+	chan->queue_flags = 0u;
+	if ((cfg->flags & IPC_SHM_CHAN_MULTI_PRODUCER) != 0u)
+		chan->queue_flags = IPC_QUEUE_MP | IPC_QUEUE_MC;
+
+	/* BD flags used by the message options both sides must enable */
+	chan->bd_flags = 0u;
+	if ((cfg->flags & IPC_SHM_CHAN_SG) != 0u)
+		chan->bd_flags |= IPC_SHM_BD_MORE;
+	if ((cfg->flags & IPC_SHM_CHAN_LARGE) != 0u)
+		chan->bd_flags |= IPC_SHM_BD_MORE | IPC_SHM_BD_LARGE;
+
+	/* check that pools are sorted in ascending order by buf size
+	 * and count total number of buffers from all pools
+	 */
+	for (i = 0; i < chan->num_pools; i++) {
+		pool_cfg = &cfg->pools[i];
+
+		if (pool_cfg->buf_size < prev_buf_size) {
+			shm_dbg("Pools must be sorted in ascending order by buffer size\n");
+			return -EINVAL;
+		}
+		prev_buf_size = pool_cfg->buf_size;
+
+		total_bufs += pool_cfg->num_bufs;
+	}
+
+	if (total_bufs > IPC_SHM_MAX_BUFS_PER_CHANNEL) {
+		return -EINVAL;
+	}
+
+	/* index first pool that may accommodate each request size class:
+	 * class i holds sizes from 2^(i-1) + 1 to 2^i
+	 */
+	pool_id = 0;
+	for (i = 0; i < IPC_SHM_SIZE_CLASSES; i++) {
+		min_size = (i == 0) ? 1u : ((1u << (i - 1)) + 1u);
+		while ((pool_id < chan->num_pools)
+				&& (cfg->pools[pool_id].buf_size < min_size))
+			pool_id++;
+		chan->size_class[i] = (uint16_t)pool_id;
+	}
+
+	/* init channel bd_queue with push ring mapped at the start of local
+	 * channel shm and pop ring mapped at start of remote channel shm
+	 */
+	err = ipc_queue_init(&chan->bd_queue, total_bufs,
+			     (uint8_t)sizeof(struct ipc_shm_bd),
+			     ipc_shm_priv_data[instance].queue_flags
+				| (chan->queue_flags & IPC_QUEUE_MP),
+			     local_shm, remote_shm);
+	if (err != 0)
+		return err;
+	if (chan->bd_flags != 0u)
+		ipc_queue_set_format(&chan->bd_queue, (uint8_t)(IPC_SHM_BD_FORMAT
+				| (chan->bd_flags << IPC_SHM_BD_FLAGS_SHIFT)));
+
+	/* init&map buffer pools after channel bd_queue */
+	queue_mem_size = ipc_queue_mem_size(&chan->bd_queue);
+	local_pool_shm = local_shm + queue_mem_size;
+	remote_pool_shm = remote_shm + queue_mem_size;
+
+	/* check if pool fits into shared memory */
+	if ((local_pool_shm)
+			> (ipc_os_get_local_shm(instance)
+				+ ipc_shm_priv_data[instance].shm_size)) {
+		shm_err("Not enough shared memory for channel %d\n",
+				chan_id);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < chan->num_pools; i++) {
+		err = ipc_buf_pool_init(instance, chan_id, i, local_pool_shm,
+				remote_pool_shm, &cfg->pools[i]);
+		if (err != 0)
+			return err;
+
+		/* compute next pool local/remote shm base address */
+		local_pool_shm += chan->pools[i].shm_size;
+		remote_pool_shm += chan->pools[i].shm_size;
+	}
+
+	return 0;
+}
+
+static int unmanaged_channel_init(const uint8_t instance, int chan_id,
+		uintptr_t local_shm, uintptr_t remote_shm,
+		const struct ipc_shm_unmanaged_cfg *cfg)
+{
+	struct ipc_unmanaged_channel *chan = get_unmanaged_chan(instance,
+			chan_id);
+
+	if (cfg->rx_cb == NULL) {
+		shm_err("Receive callback not specified\n");
+		return -EINVAL;
+	}
+
+	if (cfg->size > IPC_SHM_MAX_UMNG_SIZE) {
+		shm_err("Channel size exceeds maximum\n");
+		return -EINVAL;
+	}
+
+	/* save unmanaged channel parameters */
+	chan->size = cfg->size;
+	chan->rx_cb = cfg->rx_cb;
+	chan->cb_arg = cfg->cb_arg;
+
+	chan->local_mem = (struct ipc_channel_umem *) local_shm;
+	chan->remote_mem = (struct ipc_channel_umem *) remote_shm;
+
+	/* snapshot channels: four slots after control words */
+	chan->flags = cfg->flags;
+	chan->slot_size = (cfg->size + 7u) & ~7u;
+	chan->local_slots = NULL;
+	chan->remote_slots = NULL;
+	chan->wr_pair = 0;
+	chan->wr_slot = 0;
+	if ((cfg->flags & IPC_SHM_UMNG_SNAPSHOT) != 0u) {
+		chan->local_slots =
+			(struct ipc_umem_slots *) chan->local_mem->mem;
+		chan->remote_slots =
+			(struct ipc_umem_slots *) chan->remote_mem->mem;
+	}
+
+	/* check if channel memory fits into shared memory */
+	if ((local_shm + get_umem_memmap_size(instance, chan))
+			> (ipc_os_get_local_shm(instance)
+				+ ipc_shm_priv_data[instance].shm_size)) {
+		shm_err("Not enough shared memory for channel %d\n", chan_id);
+		return -ENOMEM;
+	}
+
+	chan->sentinel = (uint32_t)IPC_UCHAN_SENTINEL
+		^ (cfg->flags & IPC_UCHAN_SENTINEL_FLAGS_MASK);
+	chan->local_mem->sentinel = chan->sentinel;
+	chan->local_mem->tx_count = 0;
+	chan->remote_tx_count = 0;
+
+	/* latest slot is valid from init, an empty snapshot */
+	if (chan->local_slots != NULL) {
+		chan->local_slots->latest = 0;
+		chan->local_slots->slot[0] = 0;
+		chan->local_slots->slot[1] = 0;
+		chan->local_slots->reading = 0;
+		(void) memset(get_umem_slot(chan, chan->local_slots, 0, 0), 0,
+				chan->size);
+	}
+
+	return 0;
+}
+
+static int inline_channel_init(const uint8_t instance, int chan_id,
+		uintptr_t local_shm, uintptr_t remote_shm,
+		const struct ipc_shm_inline_cfg *cfg)
+{
+	struct ipc_inline_channel *chan = get_inline_chan(instance, chan_id);
+	int err;
+
+	if (cfg->rx_cb == NULL) {
+		shm_err("Receive callback not specified\n");
+		return -EINVAL;
+	}
+
+	if ((cfg->size > IPC_SHM_MAX_INLINE_SIZE)
+			|| ((cfg->size % IPC_QUEUE_MSG_ELEM_SIZE) != 0u)) {
+		shm_err("Inline channel size must be a multiple of %u, up to %u\n",
+				IPC_QUEUE_MSG_ELEM_SIZE,
+				IPC_SHM_MAX_INLINE_SIZE);
+		return -EINVAL;
+	}
+
+	/* save inline channel parameters */
+	chan->rx_cb = cfg->rx_cb;
+	chan->cb_arg = cfg->cb_arg;
+
+	/* init channel queue with push ring mapped at the start of local
+	 * channel shm and pop ring mapped at start of remote channel shm
+	 */
+	err = ipc_queue_init(&chan->queue,
+			(uint16_t)(cfg->size / IPC_QUEUE_MSG_ELEM_SIZE),
+			(uint8_t)IPC_QUEUE_MSG_ELEM_SIZE,
+			ipc_shm_priv_data[instance].queue_flags,
+			local_shm, remote_shm);
+	if (err != 0)
+		return err;
+
+	if (ipc_queue_msg_max_size(&chan->queue) == 0u) {
+		shm_err("Inline channel %d too small\n", chan_id);
+		return -EINVAL;
+	}
+
+	/* check if channel ring fits into shared memory */
+	if ((local_shm + ipc_queue_mem_size(&chan->queue))
+			> (ipc_os_get_local_shm(instance)
+				+ ipc_shm_priv_data[instance].shm_size)) {
+		shm_err("Not enough shared memory for channel %d\n",
+				chan_id);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/*
+ * clear channel and pool statistics and latency histogram and set pool
+ * low-water marks to pool size
+ */
+static void ipc_chan_stats_reset(const uint8_t instance, int chan_id)
+{
+	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
+	struct ipc_managed_channel *mchan = &chan->ch.mng;
+	int i;
+
+	(void) memset(&chan->stats, 0, sizeof(chan->stats));
+
+	if (chan->type != IPC_SHM_MANAGED)
+		return;
+
+	for (i = 0; i < mchan->num_pools; i++) {
+		mchan->pools[i].stats.acquire_fail = 0;
+		mchan->pools[i].stats.low_water = mchan->pools[i].num_bufs;
+	}
+
+	/* the Rx handler may be recording a latency meanwhile */
+	ipc_latency_write_begin(mchan->rx);
+	(void) memset(&mchan->rx->latency, 0, sizeof(mchan->rx->latency));
+	ipc_latency_write_end(mchan->rx);
+}
+
+/**
+ * ipc_shm_channel_init() - initialize shared memory IPC channel
+ * @instance:	instance id
+ * @chan_id:	channel index
+ * @local_shm:	local channel shared memory address
+ * @remote_shm: remote channel shared memory address
+ * @cfg:	channel configuration parameters
+ *
+ * Return: 0 for success, error code otherwise
+ */
+static int ipc_shm_channel_init(const uint8_t instance, int chan_id,
+		uintptr_t local_shm, uintptr_t remote_shm,
+		const struct ipc_shm_channel_cfg *cfg)
+{
+	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
+	int err;
+
+	if (cfg == NULL) {
+		shm_err("NULL channel configuration argument\n");
+		return -EINVAL;
+	}
+
+	/* save common channel parameters */
+	chan->id = chan_id;
+	chan->type = cfg->type;
+	chan->integrity_err = 0;
+	chan->integrity_calls = 0;
+	chan->priority = cfg->priority;
+	chan->weight = (cfg->weight == 0u) ? 1u : cfg->weight;
+
+	if (cfg->type == IPC_SHM_MANAGED) {
+		err = managed_channel_init(instance, chan_id, local_shm,
+				remote_shm, &cfg->ch.managed);
+	} else if (cfg->type == IPC_SHM_UNMANAGED) {
+		err = unmanaged_channel_init(instance, chan_id, local_shm,
+				remote_shm, &cfg->ch.unmanaged);
+	} else if (cfg->type == IPC_SHM_INLINE) {
+		err = inline_channel_init(instance, chan_id, local_shm,
+				remote_shm, &cfg->ch.inl);
+	} else {
+		shm_err("Invalid channel type\n");
+		err = -EINVAL;
+	}
+	if (err != 0)
+		return err;
+
+	ipc_chan_stats_reset(instance, chan_id);
+
+	shm_dbg("ipc shm channel %d initialized\n", chan_id);
+	return 0;
+}
+
+/* sort channel ids by descending Rx priority, keeping ids order otherwise */
+static void ipc_shm_init_rx_order(const uint8_t instance)
+{
+	struct ipc_shm_priv *priv = &ipc_shm_priv_data[instance];
+	uint16_t id;
+	int i, j;
+
+	for (i = 0; i < priv->num_channels; i++) {
+		id = (uint16_t)i;
+		for (j = i; j > 0; j--) {
+			if (priv->channels[priv->rx_order[j - 1]].priority
+					>= priv->channels[id].priority)
+				break;
+			priv->rx_order[j] = priv->rx_order[j - 1];
+		}
+		priv->rx_order[j] = id;
+	}
+}
+
+/* Get channel local mapped memory size */
+static uint32_t get_chan_memmap_size(const uint8_t instance, int chan_id)
+{
+	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
+	struct ipc_managed_channel *mchan;
+	uint32_t size = 0;
+	int i;
+
+	/* unmanaged channels: control structure size + channel memory size */
+	if (chan->type == IPC_SHM_UNMANAGED) {
+		return get_umem_memmap_size(instance, &chan->ch.umng);
+	}
+
+	/* inline channels: size of message queue */
+	if (chan->type == IPC_SHM_INLINE) {
+		return ipc_queue_mem_size(&chan->ch.inl.queue);
+	}
+
+	/* managed channels: size of BD queue + size of buf pools */
+	mchan = get_managed_chan(instance, chan_id);
+	size = ipc_queue_mem_size(&mchan->bd_queue);
+	for (i = 0; i < mchan->num_pools; i++) {
+		size += mchan->pools[i].shm_size;
+	}
+
+	return size;
+}
+
+/* Initialize only one instance shared memory device */
+static int ipc_shm_init_instance(uint8_t instance,
+	const struct ipc_shm_cfg *cfg)
+{
+	uintptr_t local_chan_shm;
+	uintptr_t remote_chan_shm;
+	uintptr_t local_shm;
+	uint32_t chan_size;
+	size_t chan_offset;
+	int err, i;
+
+	if (cfg == NULL) {
+		shm_err("NULL argument\n");
+		return -EINVAL;
+	}
+
+	if ((cfg->local_shm_addr == (uintptr_t) NULL)
+			|| (cfg->remote_shm_addr == (uintptr_t) NULL)) {
+		shm_err("NULL local or remote address\n");
+		return -EINVAL;
+	}
+
+	if ((cfg->num_channels < 1) ||
+		(cfg->num_channels > IPC_SHM_MAX_CHANNELS)) {
+		shm_err("Number of channels must be between 1 and %d\n",
+				IPC_SHM_MAX_CHANNELS);
+		return -EINVAL;
+	}
+
+	/* save api params */
+	ipc_shm_priv_data[instance].shm_size = cfg->shm_size;
+	ipc_shm_priv_data[instance].rx_irq = cfg->inter_core_rx_irq;
+	ipc_shm_priv_data[instance].num_channels = cfg->num_channels;
+	ipc_shm_priv_data[instance].queue_flags = 0u;
+	ipc_shm_priv_data[instance].flags = cfg->flags;
+	ipc_shm_priv_data[instance].integrity_policy = cfg->integrity_policy;
+	ipc_shm_priv_data[instance].integrity_period = cfg->integrity_period;
+	if ((cfg->integrity_policy == IPC_SHM_INTEGRITY_SAMPLED)
+			&& (cfg->integrity_period == 0u)) {
+		shm_err("Integrity check period not specified\n");
+		return -EINVAL;
+	}
+	if ((cfg->flags & IPC_SHM_RING_POW2) != 0u)
+		ipc_shm_priv_data[instance].queue_flags |= IPC_QUEUE_POW2;
+	if ((cfg->flags & IPC_SHM_RING_PADDED) != 0u) {
+		if (((cfg->local_shm_addr % IPC_QUEUE_CACHE_LINE_SIZE) != 0u)
+				|| ((cfg->remote_shm_addr
+					% IPC_QUEUE_CACHE_LINE_SIZE) != 0u)) {
+			shm_err("Shared memory not aligned to cache line size\n");
+			return -EINVAL;
+		}
+		ipc_shm_priv_data[instance].queue_flags |= IPC_QUEUE_PADDED;
+	}
+
+	/* get memory of channel and pool descriptors */
+	err = ipc_shm_desc_init(instance, cfg);
+	if (err != 0)
+		return err;
+
+	/* pass interrupt and core data to hw */
+	err = ipc_hw_init(instance, cfg);
+	if (err != 0)
+		goto err_free_desc;
+
+	/* init OS specific resources */
+	err = ipc_os_init(instance, cfg, ipc_shm_rx);
+	if (err != 0)
+		goto err_free_hw;
+
+	/* global data stored at beginning of local shared memory */
+	local_shm = ipc_os_get_local_shm(instance);
+	ipc_shm_priv_data[instance].global = (struct ipc_shm_global *)local_shm;
+	ipc_shm_priv_data[instance].rx_active = 0u;
+	if ((cfg->flags & IPC_SHM_NOTIFY_SUPPRESS) != 0u)
+		ipc_shm_priv_data[instance].global->rx_active = 0u;
+
+	/* init channels */
+	chan_offset = get_layout_size(instance, get_global_size(instance));
+	local_chan_shm = local_shm + (uintptr_t) chan_offset;
+	remote_chan_shm = ipc_os_get_remote_shm(instance)
+			+ (uintptr_t) chan_offset;
+	shm_dbg("initializing channels...\n");
+	for (i = 0; i < ipc_shm_priv_data[instance].num_channels; i++) {
+		err = ipc_shm_channel_init(instance, i, local_chan_shm,
+				remote_chan_shm, &cfg->channels[i]);
+		if (err != 0)
+			goto err_free_os;
+
+		/* compute next channel local/remote shm base address */
+		chan_size = get_chan_memmap_size(instance, i);
+		local_chan_shm += chan_size;
+		remote_chan_shm += chan_size;
+	}
+	ipc_shm_init_rx_order(instance);
+
+	/* a remote already initialized must use the same channel layouts */
+	if (ipc_remote_is_ready(instance)
+			&& (ipc_check_instance_integrity(instance) != 0)) {
+		shm_err("Channel layout or options differ from remote\n");
+		err = -EINVAL;
+		goto err_free_os;
+	}
+
+	/* enable interrupt notifications */
+	ipc_hw_irq_enable(instance);
+
+	/* publish initialized channels to remote */
+	ipc_os_store_release(&ipc_shm_priv_data[instance].global->state,
+			IPC_SHM_STATE_READY);
+	shm_dbg("ipc shm initialized\n");
+
+	return 0;
+
+err_free_os:
+	ipc_os_free(instance);
+err_free_hw:
+	ipc_hw_free(instance);
+err_free_desc:
+	ipc_shm_desc_free(instance);
+	return err;
+}
+
+size_t ipc_shm_arena_size(const struct ipc_shm_cfg *cfg)
+{
+	if ((cfg == NULL) || (cfg->num_channels < 1)
+			|| (cfg->num_channels > IPC_SHM_MAX_CHANNELS))
+		return 0;
+
+	return ipc_shm_desc_size(cfg);
+}
+
+void ipc_shm_free(void)
+{
+	uint8_t i = 0;
+
+	/* check if instance must be free */
+	for (i = 0; i < IPC_SHM_MAX_INSTANCES; i++) {
+		if (ipc_instance_is_free(i) == IPC_SHM_INSTANCE_USED) {
+
+			/* reset state */
+			ipc_shm_priv_data[i].global->state =
+				IPC_SHM_STATE_CLEAR;
+			ipc_shm_priv_data[i].global = NULL;
+
+			/* disable hardirq */
+			ipc_hw_irq_disable(i);
+
+			ipc_os_free(i);
+			ipc_hw_free(i);
+			ipc_shm_desc_free(i);
+		}
+	}
+
+	shm_dbg("ipc shm released\n");
+}
+
+/**
+ * ipc_shm_notify_remote() - notify remote that new messages are available
+ * @instance:	instance id
+ *
+ * With IPC_SHM_NOTIFY_SUPPRESS, remote is not notified while it processes
+ * received messages, because it checks all channels again before it stops.
+ */
+static void ipc_shm_notify_remote(const uint8_t instance)
+{
+	struct ipc_shm_global *remote_global;
+
+	if ((ipc_shm_priv_data[instance].flags & IPC_SHM_NOTIFY_SUPPRESS)
+			!= 0u) {
+		/* order message publish before remote flag check */
+		ipc_os_mb();
+
+		remote_global = (struct ipc_shm_global *)ipc_os_get_remote_shm(
+				instance);
+		if (ipc_os_load_acquire(&remote_global->rx_active) != 0u)
+			return;
+	}
+
+	ipc_hw_irq_notify(instance);
+}
+
+void *ipc_shm_acquire_buf(const uint8_t instance, int chan_id, size_t size)
+{
+	struct ipc_managed_channel *chan;
+	struct ipc_shm_pool *pool = NULL;
+	union ipc_shm_bd_elem elem;
+	uintptr_t buf_addr;
+	uint16_t buf_id;
+	int first_pool, last_pool, pool_id;
+	bool shared;
+
+	/* check if instance is valid */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return NULL;
+	}
+
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (size == 0u)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return NULL;
+
+	shared = ((chan->queue_flags & IPC_QUEUE_MC) != 0u);
+
+	/* best fit uses only the smallest pool that accommodates the size */
+	first_pool = get_first_pool(chan, size);
+	last_pool = chan->num_pools;
+	if ((chan->flags & IPC_SHM_CHAN_BEST_FIT) != 0u)
+		last_pool = ipc_min(first_pool + 1, chan->num_pools);
+
+	/* find first non-empty pool: a pool is likely empty while the shadow
+	 * remote write index equals the local read index, in which case pop
+	 * re-reads the remote index to catch buffers released meanwhile
+	 */
+	for (pool_id = first_pool; pool_id < last_pool; pool_id++) {
+		pool = &chan->pools[pool_id];
+
+		/* get a free BD if pool has any free buffers left */
+		if (ipc_queue_pop64(&pool->bd_queue, &elem.word) == 0)
+			break;
+
+		ipc_stat_add(&pool->stats.acquire_fail, 1u, shared);
+	}
+
+	if (pool_id == last_pool) {
+		shm_dbg("No free buffer found in channel %d\n", chan_id);
+		return NULL;
+	}
+
+	ipc_stat_low_water(&pool->stats.low_water, &pool->bd_queue,
+			shared);
+
+	buf_id = elem.bd.buf_id;
+
+	buf_addr = pool->local_pool_addr + get_buf_offset(pool, buf_id);
+
+	shm_dbg("ch %d: pool %d: acquired buffer %d with address %lx\n",
+			chan_id, pool_id, buf_id, buf_addr);
+	return (void *) buf_addr;
+}
+
+int ipc_shm_acquire_bufs(const uint8_t instance, int chan_id, size_t size,
+		void *bufs[], int n)
+{
+	struct ipc_managed_channel *chan;
+	struct ipc_shm_pool *pool;
+	union ipc_shm_bd_elem elems[IPC_SHM_TX_BATCH];
+	int count, popped, pool_id, last_pool, i;
+	int acquired = 0;
+	int pool_acquired;
+	bool shared;
+
+	/* check if instance is valid */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
+	}
+
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (size == 0u) || (bufs == NULL) || (n < 0)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
+
+	shared = ((chan->queue_flags & IPC_QUEUE_MC) != 0u);
+
+	/* take free buffers from the first pools that accommodate the size,
+	 * or only from the smallest one with best fit
+	 */
+	pool_id = get_first_pool(chan, size);
+	last_pool = chan->num_pools;
+	if ((chan->flags & IPC_SHM_CHAN_BEST_FIT) != 0u)
+		last_pool = ipc_min(pool_id + 1, chan->num_pools);
+
+	for (; (pool_id < last_pool) && (acquired < n); pool_id++) {
+		pool = &chan->pools[pool_id];
+		pool_acquired = acquired;
+		do {
+			/* pop a burst of free BDs, publishing read index once */
+			count = ipc_min(n - acquired, IPC_SHM_TX_BATCH);
+			popped = ipc_queue_pop64_n(&pool->bd_queue,
+					&elems[0].word, (uint32_t) count);
+
+			for (i = 0; i < popped; i++) {
+				bufs[acquired + i] = (void *)
+					(pool->local_pool_addr + get_buf_offset(
+						pool, elems[i].bd.buf_id));
+			}
+			acquired += popped;
+		} while ((popped == count) && (acquired < n));
+
+		if (acquired < n)
+			ipc_stat_add(&pool->stats.acquire_fail, 1u, shared);
+		if (acquired > pool_acquired)
+			ipc_stat_low_water(&pool->stats.low_water,
+					&pool->bd_queue, shared);
+	}
+
+	shm_dbg("ch %d: acquired %d of %d buffers\n", chan_id, acquired, n);
+	return acquired;
+}
+
+int ipc_shm_init(const struct ipc_shm_instances_cfg *cfg)
+{
+	uint8_t i = 0;
+	int err = 0;
+
+	if (cfg == NULL) {
+		shm_err("NULL argument\n");
+		return -EINVAL;
+	}
+
+	if ((cfg->num_instances > IPC_SHM_MAX_INSTANCES)
+			|| (cfg->num_instances == 0u))
+		return -EINVAL;
+
+	/* init all instances */
+	for (i = 0; i < cfg->num_instances; i++) {
+		err = ipc_shm_init_instance(i, &cfg->shm_cfg[i]);
+		if (err != 0)
+			return err;
+	}
+	return 0;
+}
+
+/**
+ * find_pool_for_buf() - Find the pool that owns the specified buffer.
+ * @chan:	managed channel pointer
+ * @buf:	buffer pointer
+ * @remote:	flag telling if buffer is from remote OS
+ *
+ * Uses the buffer address ranges computed at channel init, sorted in
+ * ascending address order.
+ *
+ * Return: pool index on success, -1 otherwise
+ */
+static inline int16_t find_pool_for_buf(const struct ipc_managed_channel *chan,
+		uintptr_t buf, int remote)
+{
+	const struct ipc_shm_pool_range *range = (remote == 1) ?
+			chan->remote_range : chan->local_range;
+	int16_t pool_id;
+
+	for (pool_id = 0; pool_id < chan->num_pools; pool_id++) {
+		if (buf < range[pool_id].end)
+			return (buf >= range[pool_id].start) ? pool_id : -1;
+	}
+
+	return -1;
+}
+
+/**
+ * ipc_release_find() - find pool and index of a buffer to be released
+ * @instance:	instance id
+ * @chan_id:	managed channel id
+ * @buf:	released buffer address
+ * @buf_id:	filled with buffer index in pool
+ *
+ * Return: pool index, -1 (counted as release error) if the buffer doesn't
+ *         belong to channel
+ */
+static int16_t ipc_release_find(const uint8_t instance, int chan_id,
+		const void *buf, uint16_t *buf_id)
+{
+	struct ipc_managed_channel *chan =
+		&get_channel_priv(instance, chan_id)->ch.mng;
+	struct ipc_shm_pool *pool;
+	int16_t pool_id;
+
+	pool_id = find_pool_for_buf(chan, (uintptr_t) buf, 1);
+	if (pool_id == -1) {
+		shm_err("Buffer address %p doesn't belong to channel %d\n",
+				buf, chan_id);
+		ipc_stat_add(&get_chan_stats(instance, chan_id)->release_err,
+				1u, true);
+		return -1;
+	}
+
+	pool = &chan->pools[pool_id];
+	*buf_id = get_buf_id(pool, (uintptr_t)buf - pool->remote_pool_addr);
+
+	return pool_id;
+}
+
+int ipc_shm_release_buf(const uint8_t instance, int chan_id, const void *buf)
+{
+	struct ipc_managed_channel *chan;
+	int16_t pool_id;
+	uint16_t buf_id;
+
+	/* check if instance is valid */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
+	}
+
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (buf == NULL)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
+
+	/* reassembled large messages are not held in channel buffers */
+	if (buf == chan->large_buf)
+		return 0;
+
+	/* Find the pool that owns the buffer */
+	pool_id = ipc_release_find(instance, chan_id, buf, &buf_id);
+	if (pool_id == -1)
+		return -EINVAL;
+
+	return ipc_release_bd(instance, chan_id, pool_id, buf_id);
+}
+
+int ipc_shm_release_bufs(const uint8_t instance, int chan_id,
+		const void *const bufs[], int n)
+{
+	struct ipc_managed_channel *chan;
+	int16_t pool_id;
+	uint16_t buf_id;
+	int err = 0;
+	int i;
 
-	if (cfg->rx_cb == NULL) {
-		shm_err("Receive callback not specified\n");
+	/* check if instance is valid */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	if (cfg->pools == NULL) {
-		shm_err("NULL buffer pool configuration argument\n");
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (n < 0) || ((bufs == NULL) && (n > 0))
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
 		return -EINVAL;
-	}
 
-	if ((cfg->num_pools < 1) ||
-		(cfg->num_pools > IPC_SHM_MAX_POOLS)) {
-		shm_err("Number of pools must be between 1 and %d\n",
-				IPC_SHM_MAX_POOLS);
-		return -EINVAL;
+	/* cache BDs of all buffers, then push them once per pool: BDs that
+	 * don't fit the release ring stay cached, so they are not reported
+	 * as errors (the buffers must not be released again)
+	 */
+	ipc_release_lock(chan);
+	for (i = 0; (i < n) && (err == 0); i++) {
+		if (bufs[i] == NULL) {
+			ipc_stat_add(&get_chan_stats(instance, chan_id)
+					->release_err, 1u, true);
+			err = -EINVAL;
+		} else if (bufs[i] != chan->large_buf) {
+			pool_id = ipc_release_find(instance, chan_id, bufs[i],
+					&buf_id);
+			err = (pool_id == -1) ? -EINVAL : ipc_release_cache_add(
+					instance, chan_id, pool_id, buf_id);
+		}
 	}
 
-	/* save managed channel parameters */
-	chan->rx_cb = cfg->rx_cb;
-	chan->cb_arg = cfg->cb_arg;
-	chan->num_pools = cfg->num_pools;
-
-	/* check that pools are sorted in ascending order by buf size
-	 * and count total number of buffers from all pools
-	 */
-	for (i = 0; i < chan->num_pools; i++) {
-		pool_cfg = &cfg->pools[i];
+	(void) ipc_release_flush(instance, chan_id);
+	ipc_release_unlock(chan);
 
-		if (pool_cfg->buf_size < prev_buf_size) {
-			shm_dbg("Pools must be sorted in ascending order by buffer size\n");
-			return -EINVAL;
-		}
-		prev_buf_size = pool_cfg->buf_size;
+	return err;
+}
 
-		total_bufs += pool_cfg->num_bufs;
-	}
+int ipc_shm_tx(const uint8_t instance, int chan_id, void *buf, size_t size)
+{
+	struct ipc_managed_channel *chan;
+	struct ipc_shm_chan_stats *stats;
+	struct ipc_shm_pool *pool;
+	union ipc_shm_bd_elem elem;
+	int16_t pool_id;
+	bool shared;
 
-	if (total_bufs > IPC_SHM_MAX_BUFS_PER_CHANNEL) {
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	/* init channel bd_queue with push ring mapped at the start of local
-	 * channel shm and pop ring mapped at start of remote channel shm
-	 */
-	err = ipc_queue_init(&chan->bd_queue, total_bufs,
-			     (uint8_t)sizeof(struct ipc_shm_bd),
-			     local_shm, remote_shm);
-	if (err != 0)
-		return err;
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (buf == NULL) || (size == 0u)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
 
-	/* init&map buffer pools after channel bd_queue */
-	queue_mem_size = ipc_queue_mem_size(&chan->bd_queue);
-	local_pool_shm = local_shm + queue_mem_size;
-	remote_pool_shm = remote_shm + queue_mem_size;
+	/* Find the pool that owns the buffer */
+	pool_id = find_pool_for_buf(chan, (uintptr_t) buf, 0);
+	if (pool_id == -1) {
+		shm_err("Buffer address %p doesn't belong to channel %d\n",
+				buf, chan_id);
+		return -EINVAL;
+	}
 
-	/* check if pool fits into shared memory */
-	if ((local_pool_shm)
-			> (ipc_os_get_local_shm(instance)
-				+ ipc_shm_priv_data[instance].shm_size)) {
-		shm_err("Not enough shared memory for channel %d\n",
-				chan_id);
+	pool = &chan->pools[pool_id];
+	elem.bd.pool_id = (uint8_t) pool_id;
+	elem.bd.flags = 0u;
+	elem.bd.buf_id = get_buf_id(pool,
+			(uintptr_t) buf - pool->local_pool_addr);
+	elem.bd.data_size = (uint32_t) size;
+
+	/* stamp buffer before publishing it to remote */
+	if (pool->local_ts != NULL)
+		pool->local_ts[elem.bd.buf_id] = ipc_os_get_timestamp();
+
+	/* push buffer descriptor into channel queue */
+	shared = ((chan->queue_flags & IPC_QUEUE_MP) != 0u);
+	stats = get_chan_stats(instance, chan_id);
+	if (ipc_queue_push64(&chan->bd_queue, elem.word) != 0) {
+		shm_err("Unable to push buffer descriptor in channel queue\n");
+		ipc_stat_add(&stats->tx_full, 1u, shared);
 		return -ENOMEM;
 	}
 
-	for (i = 0; i < chan->num_pools; i++) {
-		err = ipc_buf_pool_init(instance, chan_id, i, local_pool_shm,
-				remote_pool_shm, &cfg->pools[i]);
-		if (err != 0)
-			return err;
+	ipc_stat_add(&stats->tx_msgs, 1u, shared);
+	ipc_stat_add(&stats->tx_bytes, size, shared);
 
-		/* compute next pool local/remote shm base address */
-		local_pool_shm += chan->pools[i].shm_size;
-		remote_pool_shm += chan->pools[i].shm_size;
-	}
+	/* notify remote that data is available */
+	ipc_shm_notify_remote(instance);
 
 	return 0;
 }
 
-static int unmanaged_channel_init(const uint8_t instance, int chan_id,
-		uintptr_t local_shm, uintptr_t remote_shm,
-		const struct ipc_shm_unmanaged_cfg *cfg)
+int ipc_shm_chan_pending_rx(const uint8_t instance, int chan_id)
 {
-	struct ipc_unmanaged_channel *chan = get_unmanaged_chan(instance,
-			chan_id);
+	struct ipc_managed_channel *chan;
 
-	if ((cfg->rx_cb == NULL) || (cfg->size > IPC_SHM_MAX_UMNG_SIZE)) {
-		shm_err("Receive callback not specified\n");
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	/* save unmanaged channel parameters */
-	chan->size = cfg->size;
-	chan->rx_cb = cfg->rx_cb;
-	chan->cb_arg = cfg->cb_arg;
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
 
-	chan->local_mem = (struct ipc_channel_umem *) local_shm;
-	chan->remote_mem = (struct ipc_channel_umem *) remote_shm;
+	return (int)ipc_queue_count(&chan->bd_queue);
+}
 
-	chan->local_mem->sentinel = (uint32_t)IPC_UCHAN_SENTINEL;
-	chan->local_mem->tx_count = 0;
-	chan->remote_tx_count = 0;
+int ipc_shm_chan_tx_space(const uint8_t instance, int chan_id)
+{
+	struct ipc_managed_channel *chan;
 
-	return 0;
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
+	}
+
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
+
+	return (int)ipc_queue_space(&chan->bd_queue);
 }
 
-/**
- * ipc_shm_channel_init() - initialize shared memory IPC channel
- * @instance:	instance id
- * @chan_id:	channel index
- * @local_shm:	local channel shared memory address
- * @remote_shm: remote channel shared memory address
- * @cfg:	channel configuration parameters
- *
- * Return: 0 for success, error code otherwise
- */
-static int ipc_shm_channel_init(const uint8_t instance, int chan_id,
-		uintptr_t local_shm, uintptr_t remote_shm,
-		const struct ipc_shm_channel_cfg *cfg)
+int ipc_shm_pool_free_bufs(const uint8_t instance, int chan_id, int pool_id)
 {
-	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
-	int err;
+	struct ipc_managed_channel *chan;
 
-	if (cfg == NULL) {
-		shm_err("NULL channel configuration argument\n");
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	/* save common channel parameters */
-	chan->id = chan_id;
-	chan->type = cfg->type;
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
 
-	if (cfg->type == IPC_SHM_MANAGED) {
-		err = managed_channel_init(instance, chan_id, local_shm,
-				remote_shm, &cfg->ch.managed);
-	} else if (cfg->type == IPC_SHM_UNMANAGED) {
-		err = unmanaged_channel_init(instance, chan_id, local_shm,
-				remote_shm, &cfg->ch.unmanaged);
-	} else {
-		shm_err("Invalid channel type\n");
-		err = -EINVAL;
+	if ((pool_id < 0) || (pool_id >= chan->num_pools)) {
+		shm_err("Pool id outside valid range: 0 - %d\n",
+				chan->num_pools);
+		return -EINVAL;
 	}
-	if (err != 0)
-		return err;
 
-	shm_dbg("ipc shm channel %d initialized\n", chan_id);
-	return 0;
+	/* free buffers are the BDs released by remote in pool acquire ring */
+	return (int)ipc_queue_count(&chan->pools[pool_id].bd_queue);
 }
 
-/* Get channel local mapped memory size */
-static uint32_t get_chan_memmap_size(const uint8_t instance, int chan_id)
+int ipc_shm_tx_batch(const uint8_t instance, int chan_id, void *const bufs[],
+		const size_t sizes[], int n)
 {
-	struct ipc_shm_channel *chan = get_channel_priv(instance, chan_id);
-	struct ipc_managed_channel *mchan;
-	uint32_t size = 0;
-	int i;
+	struct ipc_managed_channel *chan;
+	struct ipc_shm_pool *pool;
+	union ipc_shm_bd_elem elems[IPC_SHM_TX_BATCH];
+	struct ipc_shm_chan_stats *stats;
+	uint64_t tx_bytes = 0;
+	int16_t pool_id;
+	int count, pushed, i;
+	int sent = 0;
+	bool shared;
 
-	/* unmanaged channels: control structure size + channel memory size */
-	if (chan->type == IPC_SHM_UNMANAGED) {
-		return (uint32_t)(sizeof(struct ipc_channel_umem) +
-			chan->ch.umng.size);
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
 	}
 
-	/* managed channels: size of BD queue + size of buf pools */
-	mchan = get_managed_chan(instance, chan_id);
-	size = ipc_queue_mem_size(&mchan->bd_queue);
-	for (i = 0; i < mchan->num_pools; i++) {
-		size += mchan->pools[i].shm_size;
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (bufs == NULL) || (sizes == NULL) || (n < 0)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
+
+	/* validate all buffers before sending any of them */
+	for (i = 0; i < n; i++) {
+		if ((bufs[i] == NULL) || (sizes[i] == 0u)
+				|| (find_pool_for_buf(chan, (uintptr_t) bufs[i],
+					0) == -1)) {
+			shm_err("Invalid buffer %d (%p) for channel %d\n",
+					i, bufs[i], chan_id);
+			return -EINVAL;
+		}
 	}
 
-	return size;
+	/* push buffer descriptors in bursts, publishing each burst at once */
+	while (sent < n) {
+		count = ipc_min(n - sent, IPC_SHM_TX_BATCH);
+		for (i = 0; i < count; i++) {
+			pool_id = find_pool_for_buf(chan,
+					(uintptr_t) bufs[sent + i], 0);
+			pool = &chan->pools[pool_id];
+			elems[i].bd.pool_id = (uint8_t) pool_id;
+			elems[i].bd.flags = 0u;
+			elems[i].bd.buf_id = get_buf_id(pool,
+					(uintptr_t) bufs[sent + i]
+					- pool->local_pool_addr);
+			elems[i].bd.data_size = (uint32_t) sizes[sent + i];
+
+			if (pool->local_ts != NULL)
+				pool->local_ts[elems[i].bd.buf_id] =
+					ipc_os_get_timestamp();
+		}
+
+		pushed = ipc_queue_push64_n(&chan->bd_queue, &elems[0].word,
+				(uint32_t) count);
+		for (i = 0; i < pushed; i++)
+			tx_bytes += elems[i].bd.data_size;
+		sent += pushed;
+		if (pushed < count) {
+			shm_err("Channel queue full, sent %d of %d buffers\n",
+					sent, n);
+			break;
+		}
+	}
+
+	stats = get_chan_stats(instance, chan_id);
+	shared = ((chan->queue_flags & IPC_QUEUE_MP) != 0u);
+	if (sent < n)
+		ipc_stat_add(&stats->tx_full, 1u, shared);
+	ipc_stat_add(&stats->tx_msgs, (uint64_t)sent, shared);
+	ipc_stat_add(&stats->tx_bytes, tx_bytes, shared);
+
+	/* notify remote once for all buffers sent */
+	if (sent > 0)
+		ipc_shm_notify_remote(instance);
+
+	return sent;
 }
 
-/* Initialize only one instance shared memory device */
-static int ipc_shm_init_instance(uint8_t instance,
-	const struct ipc_shm_cfg *cfg)
+int ipc_shm_tx_sg(const uint8_t instance, int chan_id, void *const bufs[],
+		const size_t sizes[], int n)
 {
-	uintptr_t local_chan_shm;
-	uintptr_t remote_chan_shm;
-	uintptr_t local_shm;
-	uint32_t chan_size;
-	size_t chan_offset;
-	int err, i;
+	struct ipc_managed_channel *chan;
+	struct ipc_shm_pool *pool;
+	union ipc_shm_bd_elem elems[IPC_SHM_MAX_SG_BUFS];
+	struct ipc_shm_chan_stats *stats;
+	uint64_t tx_bytes = 0;
+	int16_t pool_id;
+	int i;
 
-	if (cfg == NULL) {
-		shm_err("NULL argument\n");
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	if ((cfg->local_shm_addr == (uintptr_t) NULL)
-			|| (cfg->remote_shm_addr == (uintptr_t) NULL)) {
-		shm_err("NULL local or remote address\n");
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (bufs == NULL) || (sizes == NULL) || (n < 1)
+			|| (n > IPC_SHM_MAX_SG_BUFS)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
 		return -EINVAL;
-	}
 
-	if ((cfg->num_channels < 1) ||
-		(cfg->num_channels > IPC_SHM_MAX_CHANNELS)) {
-		shm_err("Number of channels must be between 1 and %d\n",
-				IPC_SHM_MAX_CHANNELS);
+	/* remote would drop chained BDs of a channel not enabling them */
+	if ((chan->flags & IPC_SHM_CHAN_SG) == 0u) {
+		shm_err("Scatter-gather Tx not enabled for channel %d\n",
+				chan_id);
 		return -EINVAL;
 	}
 
-	/* save api params */
-	ipc_shm_priv_data[instance].shm_size = cfg->shm_size;
-	ipc_shm_priv_data[instance].num_channels = cfg->num_channels;
-
-	/* pass interrupt and core data to hw */
-	err = ipc_hw_init(instance, cfg);
-	if (err != 0)
-		return err;
+	/* BDs of concurrent producers would interleave with the chain */
+	if ((chan->queue_flags & IPC_QUEUE_MP) != 0u) {
+		shm_err("Scatter-gather Tx not supported on multi-producer channel %d\n",
+				chan_id);
+		return -EINVAL;
+	}
 
-	/* init OS specific resources */
-	err = ipc_os_init(instance, cfg, ipc_shm_rx);
-	if (err != 0)
-		goto err_free_hw;
+	/* build BD chain, validating all buffers before sending any of them */
+	for (i = 0; i < n; i++) {
+		pool_id = (bufs[i] == NULL) ? -1 :
+			find_pool_for_buf(chan, (uintptr_t) bufs[i], 0);
+		if ((pool_id == -1) || (sizes[i] == 0u)) {
+			shm_err("Invalid buffer %d (%p) for channel %d\n",
+					i, bufs[i], chan_id);
+			return -EINVAL;
+		}
 
-	/* global data stored at beginning of local shared memory */
-	local_shm = ipc_os_get_local_shm(instance);
-	ipc_shm_priv_data[instance].global = (struct ipc_shm_global *)local_shm;
+		pool = &chan->pools[pool_id];
+		elems[i].bd.pool_id = (uint8_t) pool_id;
+		elems[i].bd.flags = (i < n - 1) ? IPC_SHM_BD_MORE : 0u;
+		elems[i].bd.buf_id = get_buf_id(pool,
+				(uintptr_t) bufs[i] - pool->local_pool_addr);
+		elems[i].bd.data_size = (uint32_t) sizes[i];
+		tx_bytes += sizes[i];
+	}
 
-	/* init channels */
-	chan_offset = sizeof(struct ipc_shm_global);
-	local_chan_shm = local_shm + (uintptr_t) chan_offset;
-	remote_chan_shm = ipc_os_get_remote_shm(instance)
-			+ (uintptr_t) chan_offset;
-	shm_dbg("initializing channels...\n");
-	for (i = 0; i < ipc_shm_priv_data[instance].num_channels; i++) {
-		err = ipc_shm_channel_init(instance, i, local_chan_shm,
-				remote_chan_shm, &cfg->channels[i]);
-		if (err != 0)
-			goto err_free_os;
+	/* the chain is published at once, so it must fit entirely */
+	stats = get_chan_stats(instance, chan_id);
+	if (ipc_queue_space(&chan->bd_queue) < (uint32_t) n) {
+		shm_err("Channel queue full, unable to send %d buffers\n", n);
+		ipc_stat_add(&stats->tx_full, 1u, false);
+		return -ENOMEM;
+	}
 
-		/* compute next channel local/remote shm base address */
-		chan_size = get_chan_memmap_size(instance, i);
-		local_chan_shm += chan_size;
-		remote_chan_shm += chan_size;
+	/* stamp buffers before publishing them to remote */
+	for (i = 0; i < n; i++) {
+		pool = &chan->pools[elems[i].bd.pool_id];
+		if (pool->local_ts != NULL)
+			pool->local_ts[elems[i].bd.buf_id] =
+				ipc_os_get_timestamp();
 	}
 
-	/* enable interrupt notifications */
-	ipc_hw_irq_enable(instance);
+	(void) ipc_queue_push64_n(&chan->bd_queue, &elems[0].word,
+			(uint32_t) n);
 
-	ipc_shm_priv_data[instance].global->state = IPC_SHM_STATE_READY;
-	shm_dbg("ipc shm initialized\n");
+	ipc_stat_add(&stats->tx_msgs, 1u, false);
+	ipc_stat_add(&stats->tx_bytes, tx_bytes, false);
 
-	return 0;
+	/* notify remote once for the entire message */
+	ipc_shm_notify_remote(instance);
 
-err_free_os:
-	ipc_os_free(instance);
-err_free_hw:
-	ipc_hw_free(instance);
-	return err;
+	return 0;
 }
 
-void ipc_shm_free(void)
+/**
+ * ipc_large_pool() - select pool for next fragment of a large message
+ * @chan:	managed channel
+ * @left:	message bytes left to send
+ * @replay:	select from the buffers left by the plan instead of planning
+ *
+ * The remaining data goes in the smallest pool that accommodates it, otherwise
+ * the largest pool with free buffers is used to minimize the fragment count.
+ * The selected pool's free buffer count (large_plan or large_avail) is
+ * decremented.
+ *
+ * Return: pool index, -1 if no pool has free buffers
+ */
+static int ipc_large_pool(struct ipc_managed_channel *chan, size_t left,
+		bool replay)
 {
-	uint8_t i = 0;
-
-	/* check if instance must be free */
-	for (i = 0; i < IPC_SHM_MAX_INSTANCES; i++) {
-		if (ipc_instance_is_free(i) == IPC_SHM_INSTANCE_USED) {
-
-			/* reset state */
-			ipc_shm_priv_data[i].global->state =
-				IPC_SHM_STATE_CLEAR;
-			ipc_shm_priv_data[i].global = NULL;
+	uint32_t *avail;
+	int pool_id;
 
-			/* disable hardirq */
-			ipc_hw_irq_disable(i);
+	for (pool_id = get_first_pool(chan, left); pool_id < chan->num_pools;
+			pool_id++) {
+		avail = replay ? &chan->pools[pool_id].large_avail
+			: &chan->pools[pool_id].large_plan;
+		if (*avail > 0u) {
+			(*avail)--;
+			return pool_id;
+		}
+	}
 
-			ipc_os_free(i);
-			ipc_hw_free(i);
+	for (pool_id = chan->num_pools - 1; pool_id >= 0; pool_id--) {
+		avail = replay ? &chan->pools[pool_id].large_avail
+			: &chan->pools[pool_id].large_plan;
+		if (*avail > 0u) {
+			(*avail)--;
+			return pool_id;
 		}
 	}
 
-	shm_dbg("ipc shm released\n");
+	return -1;
 }
 
-void *ipc_shm_acquire_buf(const uint8_t instance, int chan_id, size_t size)
+int ipc_shm_tx_large(const uint8_t instance, int chan_id, const void *data,
+		size_t size)
 {
 	struct ipc_managed_channel *chan;
-	struct ipc_shm_pool *pool = NULL;
-	struct ipc_shm_bd bd = {.pool_id = 0, .buf_id = 0u, .data_size = 0u};
-	uintptr_t buf_addr;
-	int pool_id;
+	struct ipc_shm_pool *pool;
+	union ipc_shm_bd_elem elems[IPC_SHM_TX_BATCH];
+	struct ipc_shm_chan_stats *stats;
+	const uint8_t *src = data;
+	uint32_t num_frags = 0;
+	uint32_t frag;
+	size_t left;
+	int pool_id, count, i;
 
-	/* check if instance is valid */
+	/* check if instance is used */
 	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
-		return NULL;
+		return -EINVAL;
 	}
 
 	chan = get_managed_chan(instance, chan_id);
-	if ((chan == NULL) || (size == 0u)
-			|| (ipc_check_mchan_integrity(chan) != 0))
-		return NULL;
+	if ((chan == NULL) || (data == NULL) || (size == 0u)
+			|| (((uint64_t)size >> 32) != 0u)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
 
-	/* find first non-empty pool that accommodates the requested size */
-	for (pool_id = 0; pool_id < chan->num_pools; pool_id++) {
-		pool = &chan->pools[pool_id];
+	/* remote would drop fragments of a channel not enabling them */
+	if ((chan->flags & IPC_SHM_CHAN_LARGE) == 0u) {
+		shm_err("Large message Tx not enabled for channel %d\n",
+				chan_id);
+		return -EINVAL;
+	}
 
-		/* check if pool buf size covers the requested size */
-		if (size > pool->buf_size)
-			continue;
+	/* BDs of concurrent producers would interleave with the fragments */
+	if ((chan->queue_flags & IPC_QUEUE_MP) != 0u) {
+		shm_err("Large message Tx not supported on multi-producer channel %d\n",
+				chan_id);
+		return -EINVAL;
+	}
 
-		/* check if pool has any free buffers left */
-		if (ipc_queue_pop(&pool->bd_queue, &bd) == 0)
-			break;
+	/* plan fragments with the free buffers of each pool, so that no buffer
+	 * is acquired unless the entire message can be sent
+	 */
+	for (i = 0; i < chan->num_pools; i++) {
+		chan->pools[i].large_plan =
+			ipc_queue_count(&chan->pools[i].bd_queue);
+		chan->pools[i].large_avail = chan->pools[i].large_plan;
+	}
+	for (left = size; left > 0u; left -= frag) {
+		pool_id = ipc_large_pool(chan, left, false);
+		if (pool_id == -1) {
+			shm_dbg("Not enough free buffers in channel %d\n",
+					chan_id);
+			return -ENOMEM;
+		}
+		frag = ipc_min(chan->pools[pool_id].buf_size, (uint32_t)left);
+		num_frags++;
 	}
 
-	if (pool_id == chan->num_pools) {
-		shm_dbg("No free buffer found in channel %d\n", chan_id);
-		return NULL;
+	stats = get_chan_stats(instance, chan_id);
+	if (ipc_queue_space(&chan->bd_queue) < num_frags) {
+		shm_err("Channel queue full, unable to send %u fragments\n",
+				num_frags);
+		ipc_stat_add(&stats->tx_full, 1u, false);
+		return -ENOMEM;
 	}
 
-	buf_addr = pool->local_pool_addr +
-		(uint32_t)(bd.buf_id * pool->buf_size);
+	/* replay the plan: copy fragments and push their BDs in bursts (pool
+	 * rings are popped only by this thread, so planned buffers are there)
+	 */
+	count = 0;
+	for (left = size; left > 0u; left -= frag) {
+		pool_id = ipc_large_pool(chan, left, true);
+		pool = &chan->pools[pool_id];
+		frag = ipc_min(pool->buf_size, (uint32_t)left);
+
+		(void) ipc_queue_pop64(&pool->bd_queue, &elems[count].word);
+		ipc_stat_low_water(&pool->stats.low_water,
+				&pool->bd_queue, false);
+		(void) memcpy((void *)(pool->local_pool_addr + get_buf_offset(
+				pool, elems[count].bd.buf_id)), src, frag);
+		src += frag;
+
+		elems[count].bd.flags = IPC_SHM_BD_LARGE;
+		if (left > frag)
+			elems[count].bd.flags |= IPC_SHM_BD_MORE;
+		elems[count].bd.data_size = frag;
+
+		if (pool->local_ts != NULL)
+			pool->local_ts[elems[count].bd.buf_id] =
+				ipc_os_get_timestamp();
+
+		count++;
+		if ((count == IPC_SHM_TX_BATCH) || (left == frag)) {
+			(void) ipc_queue_push64_n(&chan->bd_queue,
+					&elems[0].word, (uint32_t) count);
+			count = 0;
+		}
+	}
 
-	shm_dbg("ch %d: pool %d: acquired buffer %d with address %lx\n",
-			chan_id, pool_id, bd.buf_id, buf_addr);
-	return (void *) buf_addr;
+	ipc_stat_add(&stats->tx_msgs, 1u, false);
+	ipc_stat_add(&stats->tx_bytes, size, false);
+
+	/* notify remote once for the entire message */
+	ipc_shm_notify_remote(instance);
+
+	return 0;
 }
 
-int ipc_shm_init(const struct ipc_shm_instances_cfg *cfg)
+void *ipc_shm_unmanaged_acquire(const uint8_t instance, int chan_id)
 {
-	uint8_t i = 0;
-	int err = 0;
+	struct ipc_unmanaged_channel *chan = NULL;
+	uint32_t latest;
+	void *slot;
 
-	if (cfg == NULL) {
-		shm_err("NULL argument\n");
-		return -EINVAL;
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return NULL;
 	}
 
-	if ((cfg->num_instances > IPC_SHM_MAX_INSTANCES)
-			|| (cfg->num_instances == 0u))
-		return -EINVAL;
+	chan = get_unmanaged_chan(instance, chan_id);
+	if ((chan == NULL)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return NULL;
 
-	/* init all instances */
-	for (i = 0; i < cfg->num_instances; i++) {
-		err = ipc_shm_init_instance(i, &cfg->shm_cfg[i]);
-		if (err != 0)
-			return err;
+	/* snapshot channels: free slot of the pair not being read by remote
+	 * (never the latest one), initialized with the latest snapshot if app
+	 * updates it in place
+	 */
+	if (chan->local_slots != NULL) {
+		ipc_os_mb();
+		chan->wr_pair = (ipc_os_load_acquire(
+				&chan->remote_slots->reading) ^ 1u) & 1u;
+		chan->wr_slot = (chan->local_slots->slot[chan->wr_pair] ^ 1u) & 1u;
+
+		slot = get_umem_slot(chan, chan->local_slots, chan->wr_pair,
+				chan->wr_slot);
+		if ((chan->flags & IPC_SHM_UMNG_UPDATE) != 0u) {
+			latest = chan->local_slots->latest & 1u;
+			(void) memcpy(slot, get_umem_slot(chan,
+					chan->local_slots, latest,
+					chan->local_slots->slot[latest] & 1u),
+					chan->size);
+		}
+
+		return slot;
 	}
-	return 0;
+
+	/* for unmanaged channels return entire channel memory */
+	return (void *) chan->local_mem->mem;
 }
 
-/**
- * find_pool_for_buf() - Find the pool that owns the specified buffer.
- * @chan:	managed channel pointer
- * @buf:	buffer pointer
- * @remote:	flag telling if buffer is from remote OS
- *
- * Return: pool index on success, -1 otherwise
- */
-static int16_t find_pool_for_buf(struct ipc_managed_channel *chan,
-		uintptr_t buf, int remote)
+int ipc_shm_unmanaged_tx(const uint8_t instance, int chan_id)
 {
-	struct ipc_shm_pool *pool;
-	uintptr_t addr;
-	int16_t pool_id;
-	uint32_t pool_size;
+	struct ipc_unmanaged_channel *chan = NULL;
 
-	for (pool_id = 0; pool_id < chan->num_pools; pool_id++) {
-		pool = &chan->pools[pool_id];
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
+	}
 
-		addr = (remote == 1) ?
-				pool->remote_pool_addr : pool->local_pool_addr;
-		pool_size = pool->num_bufs * pool->buf_size;
+	chan = get_unmanaged_chan(instance, chan_id);
+	if ((chan == NULL)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
+		return -EINVAL;
 
-		if ((buf >= addr) && (buf < (addr + pool_size)))
-			return pool_id;
+	/* snapshot channels: publish written slot as latest */
+	if (chan->local_slots != NULL) {
+		ipc_os_store_release(&chan->local_slots->slot[chan->wr_pair],
+				chan->wr_slot);
+		ipc_os_store_release(&chan->local_slots->latest,
+				chan->wr_pair);
 	}
 
-	return -1;
+	/* bump Tx counter (publishes channel memory written by app) */
+	ipc_os_store_release(&chan->local_mem->tx_count,
+			chan->local_mem->tx_count + 1u);
+
+	ipc_stat_add(&get_chan_stats(instance, chan_id)->tx_msgs, 1u, false);
+	ipc_stat_add(&get_chan_stats(instance, chan_id)->tx_bytes, chan->size,
+			false);
+
+	/* notify remote that data is available */
+	ipc_shm_notify_remote(instance);
+
+	return 0;
 }
 
-int ipc_shm_release_buf(const uint8_t instance, int chan_id, const void *buf)
+int ipc_shm_inline_tx(const uint8_t instance, int chan_id, const void *buf,
+		size_t size)
 {
-	struct ipc_managed_channel *chan;
-	struct ipc_shm_pool *pool;
-	struct ipc_shm_bd bd;
+	struct ipc_inline_channel *chan = NULL;
 	int err;
 
-	/* check if instance is valid */
+	/* check if instance is used */
 	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	chan = get_managed_chan(instance, chan_id);
-	if ((chan == NULL) || (buf == NULL)
-			|| (ipc_check_mchan_integrity(chan) != 0))
+	chan = get_inline_chan(instance, chan_id);
+	if ((chan == NULL) || (buf == NULL) || (size == 0u)
+			|| (ipc_chan_integrity_policy(instance, chan_id) != 0))
 		return -EINVAL;
 
-	/* Find the pool that owns the buffer */
-	bd.pool_id = find_pool_for_buf(chan, (uintptr_t) buf, 1);
-	if (bd.pool_id == -1) {
-		shm_err("Buffer address %p doesn't belong to channel %d\n",
-				buf, chan_id);
+	if (size > ipc_queue_msg_max_size(&chan->queue)) {
+		shm_err("Message size %zu exceeds channel %d limit of %u\n",
+				size, chan_id,
+				ipc_queue_msg_max_size(&chan->queue));
 		return -EINVAL;
 	}
 
-	pool = &chan->pools[bd.pool_id];
-	bd.buf_id = (uint16_t)(((uintptr_t)buf - pool->remote_pool_addr) /
-			pool->buf_size);
-	bd.data_size = 0; /* reset size of written data in buffer */
-
-	err = ipc_queue_push(&pool->bd_queue, &bd);
+	/* copy message in channel ring and publish it to remote */
+	err = ipc_queue_msg_push(&chan->queue, buf, (uint32_t)size);
 	if (err != 0) {
-		shm_err("Unable to release buffer %d from pool %d from channel %d with address %p\n",
-				bd.buf_id, bd.pool_id, chan_id, buf);
+		if (err == -ENOMEM)
+			ipc_stat_add(&get_chan_stats(instance, chan_id)
+					->tx_full, 1u, false);
 		return err;
 	}
 
-	shm_dbg("ch %d: pool %d: released buffer %d with address %p\n",
-			chan_id, bd.pool_id, bd.buf_id, buf);
+	ipc_stat_add(&get_chan_stats(instance, chan_id)->tx_msgs, 1u, false);
+	ipc_stat_add(&get_chan_stats(instance, chan_id)->tx_bytes, size,
+			false);
+
+	/* notify remote that data is available */
+	ipc_shm_notify_remote(instance);
+
 	return 0;
 }
 
-int ipc_shm_tx(const uint8_t instance, int chan_id, void *buf, size_t size)
+int ipc_shm_check_integrity(const uint8_t instance)
 {
-	struct ipc_managed_channel *chan;
-	struct ipc_shm_pool *pool;
-	struct ipc_shm_bd bd;
-	int err;
-
 	/* check if instance is used */
 	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	chan = get_managed_chan(instance, chan_id);
-	if ((chan == NULL) || (buf == NULL) || (size == 0u)
-			|| (ipc_check_mchan_integrity(chan) != 0))
-		return -EINVAL;
+	return ipc_check_instance_integrity(instance);
+}
 
-	/* Find the pool that owns the buffer */
-	bd.pool_id = find_pool_for_buf(chan, (uintptr_t) buf, 0);
-	if (bd.pool_id == -1) {
-		shm_err("Buffer address %p doesn't belong to channel %d\n",
-				buf, chan_id);
+int ipc_shm_get_chan_stats(const uint8_t instance, int chan_id,
+		struct ipc_shm_chan_stats *stats)
+{
+	struct ipc_shm_channel *chan;
+
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	pool = &chan->pools[bd.pool_id];
-	bd.buf_id = (uint16_t) (((uintptr_t) buf - pool->local_pool_addr)
-			/ pool->buf_size);
-	bd.data_size = (uint32_t) size;
+	chan = get_channel(instance, chan_id);
+	if ((chan == NULL) || (stats == NULL))
+		return -EINVAL;
 
-	/* push buffer descriptor in queue */
-	err = ipc_queue_push(&chan->bd_queue, &bd);
-	if (err != 0) {
-		shm_err("Unable to push buffer descriptor in channel queue\n");
-		return err;
+	*stats = chan->stats;
+
+	return 0;
+}
+
+int ipc_shm_get_pool_stats(const uint8_t instance, int chan_id, int pool_id,
+		struct ipc_shm_pool_stats *stats)
+{
+	struct ipc_managed_channel *chan;
+
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
 	}
 
-	/* notify remote that data is available */
-	ipc_hw_irq_notify(instance);
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (stats == NULL)
+			|| (pool_id < 0) || (pool_id >= chan->num_pools))
+		return -EINVAL;
+
+	*stats = chan->pools[pool_id].stats;
 
 	return 0;
 }
 
-void *ipc_shm_unmanaged_acquire(const uint8_t instance, int chan_id)
+int ipc_shm_reset_chan_stats(const uint8_t instance, int chan_id)
 {
-	struct ipc_unmanaged_channel *chan = NULL;
-
 	/* check if instance is used */
 	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
-		return NULL;
+		return -EINVAL;
 	}
 
-	chan = get_unmanaged_chan(instance, chan_id);
-	if ((chan == NULL)
-			|| (ipc_check_uchan_integrity(chan) != 0))
-		return NULL;
+	if (get_channel(instance, chan_id) == NULL)
+		return -EINVAL;
 
-	/* for unmanaged channels return entire channel memory */
-	return (void *) chan->local_mem->mem;
+	ipc_chan_stats_reset(instance, chan_id);
+
+	return 0;
 }
 
-int ipc_shm_unmanaged_tx(const uint8_t instance, int chan_id)
+int ipc_shm_get_chan_latency(const uint8_t instance, int chan_id,
+		struct ipc_shm_chan_latency *lat)
 {
-	struct ipc_unmanaged_channel *chan = NULL;
+	struct ipc_managed_channel *chan;
+	uint32_t seq;
 
 	/* check if instance is used */
 	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
 		return -EINVAL;
 	}
 
-	chan = get_unmanaged_chan(instance, chan_id);
-	if ((chan == NULL)
-			|| (ipc_check_uchan_integrity(chan) != 0))
+	chan = get_managed_chan(instance, chan_id);
+	if ((chan == NULL) || (lat == NULL))
 		return -EINVAL;
 
-	/* bump Tx counter */
-	chan->local_mem->tx_count++;
+	if ((chan->flags & IPC_SHM_CHAN_TIMESTAMP) == 0u) {
+		shm_err("Timestamps not enabled for channel %d\n", chan_id);
+		return -EINVAL;
+	}
 
-	/* notify remote that data is available */
-	ipc_hw_irq_notify(instance);
+	/* copy again if the Rx handler updated the histogram meanwhile */
+	do {
+		seq = ipc_os_load_acquire(&chan->rx->latency_seq);
+		while ((seq & 1u) != 0u) {
+			ipc_os_cpu_relax();
+			seq = ipc_os_load_acquire(&chan->rx->latency_seq);
+		}
+
+		*lat = chan->rx->latency;
+		ipc_os_mb();
+	} while (ipc_os_load_acquire(&chan->rx->latency_seq) != seq);
 
 	return 0;
 }
 
+uint64_t ipc_shm_latency_percentile(const struct ipc_shm_chan_latency *lat,
+		uint32_t permille)
+{
+	uint64_t rank, seen = 0;
+	uint64_t bound;
+	uint32_t i;
+
+	if ((lat == NULL) || (lat->count == 0u))
+		return 0;
+
+	/* number of messages with latency up to the percentile (rounded up) */
+	rank = ((lat->count * ipc_min(permille, 1000u)) + 999u) / 1000u;
+	if (rank == 0u)
+		rank = 1u;
+
+	for (i = 0; i < (IPC_SHM_LATENCY_BUCKETS - 1u); i++) {
+		seen += lat->buckets[i];
+		if (seen >= rank)
+			break;
+	}
+
+	/* upper bound of bucket, last bucket is bounded only by max */
+	bound = (i < (IPC_SHM_LATENCY_BUCKETS - 1u)) ?
+		((2ull << i) - 1u) : lat->max;
+
+	return ipc_min(bound, lat->max);
+}
+
 int ipc_shm_is_remote_ready(const uint8_t instance)
 {
 	struct ipc_shm_global *remote_global;
@@ -983,7 +3462,7 @@ int ipc_shm_is_remote_ready(const uint8_t instance)
 	remote_global = (struct ipc_shm_global *)ipc_os_get_remote_shm(
 			instance);
 
-	if (remote_global->state != IPC_SHM_STATE_READY)
+	if (ipc_os_load_acquire(&remote_global->state) != IPC_SHM_STATE_READY)
 		return -EAGAIN;
 
 	return 0;
@@ -1003,8 +3482,95 @@ int ipc_shm_poll_channels(const uint8_t instance)
 			instance);
 
 	/* check if remote is ready before polling */
-	if (remote_global->state != IPC_SHM_STATE_READY)
+	if (ipc_os_load_acquire(&remote_global->state) != IPC_SHM_STATE_READY)
 		return -EAGAIN;
 
 	return ipc_os_poll_channels(instance);
 }
+
+/**
+ * ipc_shm_poll_selected() - poll selected channels of a polling instance
+ * @instance:	instance id (already validated)
+ * @sel:	channels to poll
+ * @budget:	available work budget (number of messages to be processed)
+ *
+ * Return: number of messages processed, error code otherwise
+ */
+static int ipc_shm_poll_selected(const uint8_t instance,
+		const struct ipc_chan_sel *sel, int budget)
+{
+	struct ipc_shm_global *remote_global;
+
+	/* the softirq will handle rx operation if rx interrupt is configured */
+	if (ipc_shm_priv_data[instance].rx_irq != IPC_IRQ_NONE)
+		return -EOPNOTSUPP;
+
+	/* global data of remote at beginning of remote shared memory */
+	remote_global = (struct ipc_shm_global *)ipc_os_get_remote_shm(
+			instance);
+
+	/* check if remote is ready before polling */
+	if (ipc_os_load_acquire(&remote_global->state) != IPC_SHM_STATE_READY)
+		return -EAGAIN;
+
+	return ipc_shm_rx_run(instance, sel, budget);
+}
+
+int ipc_shm_poll_channel_mask(const uint8_t instance,
+		const uint32_t chan_mask[], int mask_len, int budget)
+{
+	struct ipc_chan_sel sel;
+	int num_chans, last_bits, i;
+	uint32_t any = 0;
+
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
+	}
+
+	num_chans = ipc_shm_priv_data[instance].num_channels;
+	if ((chan_mask == NULL) || (mask_len < 1)
+			|| (mask_len > IPC_SHM_CHAN_MASK_LEN(num_chans))
+			|| (budget <= 0))
+		return -EINVAL;
+
+	/* check that mask selects at least one and only configured channels */
+	for (i = 0; i < mask_len; i++)
+		any |= chan_mask[i];
+	last_bits = num_chans % IPC_SHM_CHAN_MASK_BITS;
+	if ((any == 0u) || ((mask_len == IPC_SHM_CHAN_MASK_LEN(num_chans))
+			&& (last_bits != 0)
+			&& ((chan_mask[mask_len - 1] >> last_bits) != 0u))) {
+		shm_err("Channel mask selects no channel or channels outside valid range: 0 - %d\n",
+				num_chans);
+		return -EINVAL;
+	}
+
+	sel.mask = chan_mask;
+	sel.base = 0;
+	sel.len = mask_len;
+
+	return ipc_shm_poll_selected(instance, &sel, budget);
+}
+
+int ipc_shm_poll_channel(const uint8_t instance, int chan_id, int budget)
+{
+	struct ipc_chan_sel sel;
+	uint32_t word;
+
+	/* check if instance is used */
+	if (ipc_instance_is_free(instance) != IPC_SHM_INSTANCE_USED) {
+		return -EINVAL;
+	}
+
+	if ((get_channel(instance, chan_id) == NULL) || (budget <= 0))
+		return -EINVAL;
+
+	/* one word bitmap starting at the word of the channel */
+	word = 1u << (chan_id % IPC_SHM_CHAN_MASK_BITS);
+	sel.mask = &word;
+	sel.base = chan_id - (chan_id % IPC_SHM_CHAN_MASK_BITS);
+	sel.len = 1;
+
+	return ipc_shm_poll_selected(instance, &sel, budget);
+}
@@ -6,17 +6,29 @@
 #define IPC_SHM_H
 
 /*
- * Maximum number of shared memory channels that can be configured
+ * Maximum number of shared memory channels that can be configured. Channel
+ * descriptors are allocated at init, only for configured channels, so this is
+ * not a memory reservation. It defaults to the range of the 16-bit channel
+ * index kept in the Rx scheduling order and can only be lowered.
  */
 #ifndef IPC_SHM_MAX_CHANNELS
-#define IPC_SHM_MAX_CHANNELS 8
+#define IPC_SHM_MAX_CHANNELS 65535
+#endif
+#if (IPC_SHM_MAX_CHANNELS > 65535)
+#error "IPC_SHM_MAX_CHANNELS exceeds the 16-bit channel index range"
 #endif
 
 /*
- * Maximum number of buffer pools that can be configured for a managed channel
+ * Maximum number of buffer pools that can be configured for a managed channel.
+ * Pool descriptors are allocated at init, only for configured pools, so this is
+ * not a memory reservation. It defaults to the range of the 8-bit pool index
+ * carried in buffer descriptors and can only be lowered.
  */
 #ifndef IPC_SHM_MAX_POOLS
-#define IPC_SHM_MAX_POOLS 4
+#define IPC_SHM_MAX_POOLS 256
+#endif
+#if (IPC_SHM_MAX_POOLS > 256)
+#error "IPC_SHM_MAX_POOLS exceeds the 8-bit pool index range"
 #endif
 
 /*
@@ -45,23 +57,57 @@
 
 #define IPC_UINT16_MAX 0xFFFFu
 
+/*
+ * Number of deferred buffer releases cached per pool before they are flushed
+ */
+#ifndef IPC_SHM_RELEASE_CACHE_SIZE
+#define IPC_SHM_RELEASE_CACHE_SIZE 16
+#endif
+
+/*
+ * Maximum number of buffers of a scatter-gather message
+ */
+#ifndef IPC_SHM_MAX_SG_BUFS
+#define IPC_SHM_MAX_SG_BUFS 16
+#endif
+
+/* Number of channels selected by each word of a poll channel mask */
+#define IPC_SHM_CHAN_MASK_BITS 32
+
+/* Number of poll channel mask words needed to select any of num channels */
+#define IPC_SHM_CHAN_MASK_LEN(num) \
+	(((num) + IPC_SHM_CHAN_MASK_BITS - 1) / IPC_SHM_CHAN_MASK_BITS)
+
+/* Number of log2 buckets of channel latency histogram */
+#define IPC_SHM_LATENCY_BUCKETS 32u
+
 /* Maximum number of total buffers per channel */
 #define IPC_SHM_MAX_BUFS_PER_CHANNEL (IPC_UINT16_MAX - 1u)
 
 /* Maximum unmanaged channel size */
 #define IPC_SHM_MAX_UMNG_SIZE (IPC_UINT16_MAX)
 
+/* Maximum inline channel ring size */
+#define IPC_SHM_MAX_INLINE_SIZE (IPC_UINT16_MAX * 8u)
+
 /**
  * enum ipc_shm_channel_type - channel type
  * @IPC_SHM_MANAGED:	channel with buffer management enabled
  * @IPC_SHM_UNMANAGED:	buf mgmt disabled, app owns entire channel memory
+ * @IPC_SHM_INLINE:	small messages copied inline in channel ring
  *
  * For unmanaged channels the application has full control over channel memory
  * and no buffer management is done by ipc-shm device.
+ *
+ * For inline channels each message is copied in the channel ring after a
+ * length header, so no buffer needs to be acquired and released. This suits
+ * small messages (e.g. signals), for which the copy costs less than the pool
+ * management.
  */
 enum ipc_shm_channel_type {
 	IPC_SHM_MANAGED,
-	IPC_SHM_UNMANAGED
+	IPC_SHM_UNMANAGED,
+	IPC_SHM_INLINE
 };
 
 /**
@@ -112,6 +158,98 @@ enum ipc_shm_core_index {
 	IPC_CORE_INDEX_7 = 0x80u,
 };
 
+/**
+ * enum ipc_shm_instance_flags - instance options
+ * @IPC_SHM_RING_POW2:	use power-of-two sized rings with free-running indexes
+ * @IPC_SHM_RING_PADDED:	place ring indexes and ring data on separate cache
+ *			lines (IPC_QUEUE_CACHE_LINE_SIZE)
+ * @IPC_SHM_NOTIFY_SUPPRESS:	don't notify remote while it processes
+ *			received messages
+ *
+ * Instance options change the layout of the shared memory and must be
+ * configured identically on local and remote side.
+ *
+ * When using padded rings, local and remote shared memory addresses must be
+ * aligned to the cache line size.
+ */
+enum ipc_shm_instance_flags {
+	IPC_SHM_RING_POW2 = 0x01u,
+	IPC_SHM_RING_PADDED = 0x02u,
+	IPC_SHM_NOTIFY_SUPPRESS = 0x04u,
+};
+
+/**
+ * enum ipc_shm_integrity_policy - channel integrity check policy
+ * @IPC_SHM_INTEGRITY_ALWAYS:	check channel sentinels on every API call
+ * @IPC_SHM_INTEGRITY_SAMPLED:	check channel sentinels every integrity_period
+ *				API calls on the same channel
+ * @IPC_SHM_INTEGRITY_BACKGROUND:	check all channel sentinels from
+ *				ipc_shm_check_integrity() and each Rx handler run
+ *
+ * A corrupted channel is reported by all subsequent API calls. With sampled or
+ * background policies, API calls only test a local error flag, latched when a
+ * check finds a corrupted channel.
+ */
+enum ipc_shm_integrity_policy {
+	IPC_SHM_INTEGRITY_ALWAYS = 0,
+	IPC_SHM_INTEGRITY_SAMPLED,
+	IPC_SHM_INTEGRITY_BACKGROUND,
+};
+
+/**
+ * enum ipc_shm_channel_flags - managed channel options
+ * @IPC_SHM_CHAN_MULTI_PRODUCER:	ipc_shm_acquire_buf() and ipc_shm_tx() can
+ *				be called concurrently by multiple threads
+ * @IPC_SHM_CHAN_DEFER_RELEASE:	ipc_shm_release_buf() caches buffers released
+ *				during Rx passes and returns them to remote in
+ *				batches
+ * @IPC_SHM_CHAN_TIMESTAMP:	sent buffers are timestamped and the Tx to Rx
+ *				callback latency is recorded in a histogram
+ * @IPC_SHM_CHAN_BEST_FIT:	buffers are acquired only from the smallest pool
+ *				that accommodates the requested size, instead
+ *				of spilling over to larger pools when it is
+ *				empty
+ * @IPC_SHM_CHAN_SG:		scatter-gather messages can be sent with
+ *				ipc_shm_tx_sg()
+ * @IPC_SHM_CHAN_LARGE:		large messages can be sent with
+ *				ipc_shm_tx_large() and reassembled in rx_large_buf
+ *
+ * Channel options only change local behavior and don't need to match remote
+ * channel configuration, except IPC_SHM_CHAN_TIMESTAMP which adds a timestamp
+ * array after the buffers of each pool, and IPC_SHM_CHAN_SG and
+ * IPC_SHM_CHAN_LARGE which enable buffer descriptor flags. These must be set on
+ * both sides: they are encoded in the channel queue sentinel, so a mismatch is
+ * reported as a channel integrity error. Received buffer descriptors with flags
+ * not enabled on the channel are dropped.
+ */
+enum ipc_shm_channel_flags {
+	IPC_SHM_CHAN_MULTI_PRODUCER = 0x01u,
+	IPC_SHM_CHAN_DEFER_RELEASE = 0x02u,
+	IPC_SHM_CHAN_TIMESTAMP = 0x04u,
+	IPC_SHM_CHAN_BEST_FIT = 0x08u,
+	IPC_SHM_CHAN_SG = 0x10u,
+	IPC_SHM_CHAN_LARGE = 0x20u,
+};
+
+/**
+ * enum ipc_shm_unmanaged_flags - unmanaged channel options
+ * @IPC_SHM_UMNG_SNAPSHOT:	channel memory is written in one of four slots,
+ *				so that remote always reads a consistent
+ *				snapshot, without retries or copies
+ * @IPC_SHM_UMNG_UPDATE:	ipc_shm_unmanaged_acquire() returns the snapshot
+ *				slot holding a copy of the last snapshot sent,
+ *				so that app can update part of it
+ *
+ * Snapshot channels use four times the channel size of shared memory and the
+ * option must be set on both sides: it is encoded in the channel sentinel, so
+ * a mismatch is reported as a channel integrity error. IPC_SHM_UMNG_UPDATE only
+ * changes local behavior and is used only with IPC_SHM_UMNG_SNAPSHOT.
+ */
+enum ipc_shm_unmanaged_flags {
+	IPC_SHM_UMNG_SNAPSHOT = 0x01u,
+	IPC_SHM_UMNG_UPDATE = 0x02u,
+};
+
 /**
  * struct ipc_shm_pool_cfg - memory buffer pool parameters
  * @num_bufs:   number of buffers
@@ -122,19 +260,56 @@ struct ipc_shm_pool_cfg {
 	uint32_t buf_size;
 };
 
+/**
+ * struct ipc_shm_sg_buf - buffer of a scatter-gather message
+ * @buf:    buffer pointer
+ * @size:   size of data written in buffer
+ */
+struct ipc_shm_sg_buf {
+	void *buf;
+	size_t size;
+};
+
 /**
  * struct ipc_shm_managed_cfg - managed channel parameters
  * @num_pools:   number of buffer pools
  * @pools:       memory buffer pools parameters
  * @rx_cb:       receive callback
+ * @rx_sg_cb:    optional receive callback for messages sent with
+ *               ipc_shm_tx_sg(), called once with all message buffers
  * @cb_arg:      optional receive callback argument
+ * @flags:       channel options mask from &enum ipc_shm_channel_flags
+ * @rx_large_buf:  optional buffer where messages sent with ipc_shm_tx_large()
+ *                 are reassembled, NULL to allocate it at init (required
+ *                 when the instance descriptors are in an arena)
+ * @rx_large_size: size of reassembly buffer, 0 to disable reassembly (used
+ *                 only with IPC_SHM_CHAN_LARGE)
+ *
+ * Without rx_sg_cb, the buffers of scatter-gather messages are handed one by
+ * one to rx_cb. With rx_sg_cb, single buffer messages are still handed to
+ * rx_cb. Either way, the app must release each received buffer.
+ *
+ * Reassembled large messages are handed to rx_cb in the reassembly buffer,
+ * which is valid until rx_cb returns. Releasing it is allowed and does nothing.
+ * Large messages that don't fit the reassembly buffer, or received without
+ * reassembly buffer (rx_large_size 0), are dropped and counted in rx_dropped.
+ *
+ * On IPC_SHM_CHAN_LARGE channels the Rx handler releases fragment buffers
+ * while app threads may release other buffers, so the pool release rings are
+ * multi-producer (compare-and-swap on each release) unless the channel is
+ * configured with IPC_SHM_CHAN_DEFER_RELEASE.
  */
 struct ipc_shm_managed_cfg {
 	int num_pools;
 	struct ipc_shm_pool_cfg *pools;
 	void (*rx_cb)(void *cb_arg, const uint8_t instance, int chan_id,
 			void *buf, size_t size);
+	void (*rx_sg_cb)(void *cb_arg, const uint8_t instance, int chan_id,
+			const struct ipc_shm_sg_buf *sg, int n);
 	void *cb_arg;
+	uint32_t flags;
+	void *rx_large_buf;
+	uint32_t rx_large_size;
 };
 
 /**
@@ -142,12 +317,33 @@ struct ipc_shm_managed_cfg {
  * @size:     unmanaged channel memory size
  * @rx_cb:    receive callback
  * @cb_arg:   optional receive callback argument
+ * @flags:    channel options mask from &enum ipc_shm_unmanaged_flags
+ *
+ * For snapshot channels, the memory passed to rx_cb holds the latest complete
+ * snapshot written by remote and is not modified until rx_cb returns.
  */
 struct ipc_shm_unmanaged_cfg {
 	uint32_t size;
 	void (*rx_cb)(void *cb_arg, const uint8_t instance, int chan_id,
 			void *mem);
 	void *cb_arg;
+	uint32_t flags;
+};
+
+/**
+ * struct ipc_shm_inline_cfg - inline channel parameters
+ * @size:     inline channel ring size in bytes
+ * @rx_cb:    receive callback
+ * @cb_arg:   optional receive callback argument
+ *
+ * Each message uses an 8 byte header plus its size rounded up to 8 bytes of
+ * the ring. A message can't be larger than half of the ring minus the header.
+ */
+struct ipc_shm_inline_cfg {
+	uint32_t size;
+	void (*rx_cb)(void *cb_arg, const uint8_t instance, int chan_id,
+			void *buf, size_t size);
+	void *cb_arg;
 };
 
 /**
@@ -155,12 +351,23 @@ struct ipc_shm_unmanaged_cfg {
  * @type:	channel type from &enum ipc_shm_channel_type
  * @ch.managed:     managed channel parameters
  * @ch.unmanaged:   unmanaged channel parameters
+ * @ch.inl:         inline channel parameters
+ * @priority:       Rx scheduling priority, channels with higher priority are
+ *                  drained before channels with lower priority (default 0)
+ * @weight:         Rx budget share among channels with same priority,
+ *                  relative to their weights (0 is handled as 1)
+ *
+ * Scheduling parameters only change local Rx handling and don't need to
+ * match remote channel configuration.
  */
 struct ipc_shm_channel_cfg {
 	enum ipc_shm_channel_type type;
+	uint8_t priority;
+	uint8_t weight;
 	union {
 		struct ipc_shm_managed_cfg managed;
 		struct ipc_shm_unmanaged_cfg unmanaged;
+		struct ipc_shm_inline_cfg inl;
 	} ch;
 };
 
@@ -207,6 +414,13 @@ struct ipc_shm_local_core {
  * @remote_core:	remote core to trigger the interrupt on
  * @num_channels:	number of shared memory channels
  * @channels:		IPC channels' parameters array
+ * @flags:		instance options mask from &enum ipc_shm_instance_flags
+ * @integrity_policy:	channel integrity check policy
+ * @integrity_period:	number of API calls between channel integrity checks
+ *			(IPC_SHM_INTEGRITY_SAMPLED only)
+ * @arena:		optional 8 byte aligned memory for channel and pool
+ *			descriptors, NULL to allocate them at init
+ * @arena_size:		size of arena, at least ipc_shm_arena_size(cfg)
  *
  * The TX and RX interrupts used must be different. For ARM platforms, a default
  * value can be assigned to the local and remote core using IPC_CORE_DEFAULT.
@@ -225,6 +439,11 @@ struct ipc_shm_cfg {
 	struct ipc_shm_remote_core remote_core;
 	int num_channels;
 	struct ipc_shm_channel_cfg *channels;
+	uint32_t flags;
+	enum ipc_shm_integrity_policy integrity_policy;
+	uint32_t integrity_period;
+	void *arena;
+	size_t arena_size;
 };
 
 /**
@@ -238,6 +457,70 @@ struct ipc_shm_instances_cfg {
 	struct ipc_shm_cfg *shm_cfg;
 };
 
+/**
+ * struct ipc_shm_chan_stats - channel runtime statistics
+ * @tx_msgs:         number of messages sent
+ * @tx_bytes:        number of bytes sent
+ * @rx_msgs:         number of messages received
+ * @rx_bytes:        number of bytes received
+ * @tx_full:         number of Tx operations rejected because ring was full
+ * @rx_dropped:      number of received messages dropped (large messages that
+ *                   don't fit the reassembly buffer or have a fragment
+ *                   larger than its buffer) and of buffer descriptors
+ *                   received with an invalid pool or buffer index
+ * @release_err:     number of buffers that couldn't be released
+ * @integrity_err:   number of API calls rejected by channel integrity check
+ *
+ * Unmanaged channel messages are counted with the full channel memory size.
+ * Buffer pool statistics of managed channels are read separately with
+ * ipc_shm_get_pool_stats().
+ */
+struct ipc_shm_chan_stats {
+	uint64_t tx_msgs;
+	uint64_t tx_bytes;
+	uint64_t rx_msgs;
+	uint64_t rx_bytes;
+	uint32_t tx_full;
+	uint32_t rx_dropped;
+	uint32_t release_err;
+	uint32_t integrity_err;
+};
+
+/**
+ * struct ipc_shm_pool_stats - buffer pool runtime statistics
+ * @acquire_fail:    number of acquire requests that found pool empty
+ * @low_water:       lowest number of free buffers seen in pool by acquire,
+ *                   reading remote memory only when the locally known
+ *                   number is below the mark (not tracked with
+ *                   IPC_SHM_CHAN_MULTI_PRODUCER)
+ */
+struct ipc_shm_pool_stats {
+	uint32_t acquire_fail;
+	uint32_t low_water;
+};
+
+/**
+ * struct ipc_shm_chan_latency - channel Tx to Rx callback latency histogram
+ * @count:           number of messages measured
+ * @min:             minimum latency
+ * @max:             maximum latency
+ * @sum:             sum of all latencies, used to compute the average
+ * @buckets:         number of messages per latency range: bucket i counts
+ *                   latencies in [2^i, 2^(i+1)), bucket 0 also counts 0 and
+ *                   the last bucket counts all larger latencies
+ *
+ * Latencies are measured in ticks of the counter returned by
+ * ipc_os_get_timestamp() (ARM generic timer on AArch64), which must be
+ * readable and synchronized on both cores.
+ */
+struct ipc_shm_chan_latency {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+	uint32_t buckets[IPC_SHM_LATENCY_BUCKETS];
+};
+
 /**
  * ipc_shm_init() - initialize shared memory device
  * @cfg:              configuration parameters
@@ -248,6 +531,20 @@ struct ipc_shm_instances_cfg {
  */
 int ipc_shm_init(const struct ipc_shm_instances_cfg *cfg);
 
+/**
+ * ipc_shm_arena_size() - get descriptor memory size of an instance
+ * @cfg:              instance configuration parameters
+ *
+ * Channel and pool descriptors are sized from the instance configuration and
+ * allocated at init, unless the app provides an arena in cfg (e.g. for builds
+ * without dynamic memory allocation). The arena must stay valid until
+ * ipc_shm_free() is called.
+ * Function is thread-safe.
+ *
+ * Return: arena size needed by cfg, 0 if cfg is invalid
+ */
+size_t ipc_shm_arena_size(const struct ipc_shm_cfg *cfg);
+
 /**
  * ipc_shm_free() - release all instances of shared memory device
  *
@@ -262,12 +559,40 @@ void ipc_shm_free(void);
  * @size:           required size
  *
  * Function used only for managed channels where buffer management is enabled.
- * Function is thread-safe for different channels but not for the same channel.
+ * The buffer is taken from the smallest pool that accommodates the size or,
+ * if it is empty, from the next larger pools (unless IPC_SHM_CHAN_BEST_FIT).
+ * Free buffers are counted from the shadow copy of the remote write index of
+ * the pool ring, which is re-read from remote memory only when the shadow
+ * shows no free buffer, so buffers released by remote meanwhile are found.
+ * Function is thread-safe for different channels but not for the same channel,
+ * unless the channel is configured with IPC_SHM_CHAN_MULTI_PRODUCER.
  *
  * Return: pointer to the buffer base address or NULL if buffer not found
  */
 void *ipc_shm_acquire_buf(const uint8_t instance, int chan_id, size_t size);
 
+/**
+ * ipc_shm_acquire_bufs() - request multiple buffers for the given channel
+ * @instance:       instance id
+ * @chan_id:        channel index
+ * @size:           required size of each buffer
+ * @bufs:           array filled with acquired buffer base addresses
+ * @n:              number of buffers requested
+ *
+ * Same as calling ipc_shm_acquire_buf() n times, but the channel is validated
+ * once and the free buffers are popped from pools in bursts. Buffers are taken
+ * from the first pool that accommodates the size and, when it runs out, from
+ * the next ones.
+ *
+ * Function used only for managed channels where buffer management is enabled.
+ * Function is thread-safe for different channels but not for the same channel,
+ * unless the channel is configured with IPC_SHM_CHAN_MULTI_PRODUCER.
+ *
+ * Return: number of buffers acquired (0 if none found), error code otherwise
+ */
+int ipc_shm_acquire_bufs(const uint8_t instance, int chan_id, size_t size,
+		void *bufs[], int n);
+
 /**
  * ipc_shm_release_buf() - release a buffer for the given channel
  * @instance:       instance id
@@ -277,10 +602,42 @@ void *ipc_shm_acquire_buf(const uint8_t instance, int chan_id, size_t size);
  * Function used only for managed channels where buffer management is enabled.
  * Function is thread-safe for different channels but not for the same channel.
  *
+ * If the channel is configured with IPC_SHM_CHAN_DEFER_RELEASE, a buffer
+ * released while an Rx pass of the channel is running is cached locally and
+ * made available to remote when IPC_SHM_RELEASE_CACHE_SIZE buffers of the same
+ * pool are cached, at the end of the pass or when ipc_shm_release_bufs() is
+ * called. Buffers released while no Rx pass is running are made available
+ * right away, together with the cached ones. The release cache is locked, so
+ * such channels may release buffers from the Rx callback or from any other
+ * thread, also concurrently.
+ *
  * Return: 0 on success, error code otherwise
  */
 int ipc_shm_release_buf(const uint8_t instance, int chan_id, const void *buf);
 
+/**
+ * ipc_shm_release_bufs() - release multiple buffers for the given channel
+ * @instance:       instance id
+ * @chan_id:        channel index
+ * @bufs:           array of buffer pointers
+ * @n:              number of buffers to release
+ *
+ * Function used only for managed channels where buffer management is enabled.
+ * Buffers are returned to remote with one write index update per pool, along
+ * with any release deferred by ipc_shm_release_buf(). It can be called with
+ * n = 0 to only flush deferred releases. Buffers that don't fit the release
+ * ring yet are kept and returned by the next flush, they must not be released
+ * again. For IPC_SHM_CHAN_DEFER_RELEASE channels, it can be called from the Rx
+ * callback or from any other thread.
+ * Function is thread-safe for different channels but not for the same channel,
+ * unless the channel is configured with IPC_SHM_CHAN_DEFER_RELEASE.
+ *
+ * Return: 0 on success, error code otherwise (no buffer after the first
+ * invalid one is released)
+ */
+int ipc_shm_release_bufs(const uint8_t instance, int chan_id,
+		const void *const bufs[], int n);
+
 /**
  * ipc_shm_tx() - send data on given channel and notify remote
  * @instance:       instance id
@@ -289,12 +646,123 @@ int ipc_shm_release_buf(const uint8_t instance, int chan_id, const void *buf);
  * @size:           size of data written in buffer
  *
  * Function used only for managed channels where buffer management is enabled.
- * Function is thread-safe for different channels but not for the same channel.
+ * Function is thread-safe for different channels but not for the same channel,
+ * unless the channel is configured with IPC_SHM_CHAN_MULTI_PRODUCER.
  *
  * Return: 0 on success, error code otherwise
  */
 int ipc_shm_tx(const uint8_t instance, int chan_id, void *buf, size_t size);
 
+/**
+ * ipc_shm_tx_batch() - send multiple buffers on given channel, notify once
+ * @instance:       instance id
+ * @chan_id:        channel index
+ * @bufs:           buffer pointers
+ * @sizes:          size of data written in each buffer
+ * @n:              number of buffers
+ *
+ * Same as calling ipc_shm_tx() for each buffer, but the buffer descriptors are
+ * published in bursts and remote is notified only once. All buffers are
+ * validated before any of them is sent. If the channel queue gets full, only
+ * the leading buffers are sent and the caller keeps ownership of the others.
+ *
+ * Function used only for managed channels where buffer management is enabled.
+ * Function is thread-safe for different channels but not for the same channel,
+ * unless the channel is configured with IPC_SHM_CHAN_MULTI_PRODUCER.
+ *
+ * Return: number of buffers sent, error code otherwise
+ */
+int ipc_shm_tx_batch(const uint8_t instance, int chan_id, void *const bufs[],
+		const size_t sizes[], int n);
+
+/**
+ * ipc_shm_tx_sg() - send a message made of multiple buffers on given channel
+ * @instance:       instance id
+ * @chan_id:        channel index
+ * @bufs:           buffer pointers, in message order
+ * @sizes:          size of data written in each buffer
+ * @n:              number of buffers (1 to IPC_SHM_MAX_SG_BUFS)
+ *
+ * Buffers may come from different pools, so a message larger than the biggest
+ * pool buffer can be sent without configuring pools for the largest message.
+ * The buffer descriptors are chained and published at once: either all buffers
+ * are sent or none of them (-ENOMEM if the channel queue has no room for all).
+ * Remote receives the message in its rx_sg_cb callback.
+ *
+ * Function used only for managed channels configured with IPC_SHM_CHAN_SG.
+ * Function is thread-safe for different channels but not for the same channel.
+ * It is not supported on channels configured with IPC_SHM_CHAN_MULTI_PRODUCER.
+ *
+ * Return: 0 on success, error code otherwise
+ */
+int ipc_shm_tx_sg(const uint8_t instance, int chan_id, void *const bufs[],
+		const size_t sizes[], int n);
+
+/**
+ * ipc_shm_tx_large() - copy and send a message larger than pool buffers
+ * @instance:       instance id
+ * @chan_id:        channel index
+ * @data:           message data
+ * @size:           message size
+ *
+ * The message is copied in as many channel buffers as needed, taken from the
+ * smallest pool that accommodates the remaining data or else from the largest
+ * pool with free buffers. Remote reassembles the fragments in its reassembly
+ * buffer (rx_large_buf) before calling rx_cb once with the entire message.
+ * Buffers are acquired only if the entire message can be sent, otherwise
+ * -ENOMEM is returned and nothing is sent.
+ *
+ * Function used only for managed channels configured with IPC_SHM_CHAN_LARGE.
+ * Function is thread-safe for different channels but not for the same channel.
+ * It is not supported on channels configured with IPC_SHM_CHAN_MULTI_PRODUCER.
+ *
+ * Return: 0 on success, error code otherwise
+ */
+int ipc_shm_tx_large(const uint8_t instance, int chan_id, const void *data,
+		size_t size);
+
+/**
+ * ipc_shm_chan_pending_rx() - number of received messages not yet processed
+ * @instance:       instance id
+ * @chan_id:        channel index
+ *
+ * Function used only for managed channels where buffer management is enabled.
+ * The result is a snapshot, remote may send more messages at any time.
+ * Function is thread-safe.
+ *
+ * Return: number of pending messages, error code otherwise
+ */
+int ipc_shm_chan_pending_rx(const uint8_t instance, int chan_id);
+
+/**
+ * ipc_shm_chan_tx_space() - number of messages that can be sent right now
+ * @instance:       instance id
+ * @chan_id:        channel index
+ *
+ * Function used only for managed channels where buffer management is enabled.
+ * It returns the free room in channel Tx queue; sending also needs free
+ * buffers (see ipc_shm_pool_free_bufs()). The result is a snapshot, room
+ * increases when remote processes messages.
+ * Function is thread-safe.
+ *
+ * Return: number of messages that can be sent, error code otherwise
+ */
+int ipc_shm_chan_tx_space(const uint8_t instance, int chan_id);
+
+/**
+ * ipc_shm_pool_free_bufs() - number of buffers that can be acquired from pool
+ * @instance:       instance id
+ * @chan_id:        channel index
+ * @pool_id:        pool index in channel
+ *
+ * Function used only for managed channels where buffer management is enabled.
+ * The result is a snapshot, buffers are returned when remote releases them.
+ * Function is thread-safe.
+ *
+ * Return: number of free buffers in pool, error code otherwise
+ */
+int ipc_shm_pool_free_bufs(const uint8_t instance, int chan_id, int pool_id);
+
 /**
  * ipc_shm_unmanaged_acquire() - acquire the unmanaged channel local memory
  * @instance:       instance id
@@ -302,6 +770,12 @@ int ipc_shm_tx(const uint8_t instance, int chan_id, void *buf, size_t size);
  *
  * Function used only for unmanaged channels. The memory must be acquired only
  * once after the channel is initialized. There is no release function needed.
+ * For IPC_SHM_UMNG_SNAPSHOT channels, the memory must be acquired before each
+ * snapshot is written, since each snapshot is written in another slot, and
+ * the app must write the entire snapshot in the returned slot. Channels also
+ * configured with IPC_SHM_UMNG_UPDATE get the slot holding a copy of the last
+ * snapshot sent (zeroed before the first one), so the app may update only part
+ * of it; the copy costs one channel size memcpy per call.
  * Function is thread-safe for different channels but not for the same channel.
  *
  * Return: pointer to the channel memory or NULL if invalid channel
@@ -315,13 +789,124 @@ void *ipc_shm_unmanaged_acquire(const uint8_t instance, int chan_id);
  *
  * Function used only for unmanaged channels. It can be used after the channel
  * memory has been acquired whenever is needed to signal remote that new data
- * is available in channel memory.
+ * is available in channel memory. For IPC_SHM_UMNG_SNAPSHOT channels, it also
+ * publishes the last acquired slot as the latest snapshot.
  * Function is thread-safe for different channels but not for the same channel.
  *
  * Return: 0 on success, error code otherwise
  */
 int ipc_shm_unmanaged_tx(const uint8_t instance, int chan_id);
 
+/**
+ * ipc_shm_inline_tx() - copy a message in inline channel and notify remote
+ * @instance:       instance id
+ * @chan_id:        channel index
+ * @buf:            message pointer
+ * @size:           message size
+ *
+ * Function used only for inline channels. The message is copied in the channel
+ * ring, so the buffer can be reused by the caller as soon as function returns.
+ * The remote Rx callback receives a pointer to the message in the ring, which
+ * is valid only until the callback returns.
+ * Function is thread-safe for different channels but not for the same channel.
+ *
+ * Return: 0 on success, -ENOMEM if channel ring is full, error code otherwise
+ */
+int ipc_shm_inline_tx(const uint8_t instance, int chan_id, const void *buf,
+		size_t size);
+
+/**
+ * ipc_shm_check_integrity() - check integrity of all instance channels
+ * @instance:        instance id
+ *
+ * Checks the sentinels of all channel rings and latches an error for each
+ * corrupted channel. With IPC_SHM_INTEGRITY_BACKGROUND policy it should be
+ * called periodically by the application (e.g. from a timer).
+ * Function is thread-safe for different instances but not for same instance.
+ *
+ * Return: 0 if no channel is corrupted, error code otherwise
+ */
+int ipc_shm_check_integrity(const uint8_t instance);
+
+/**
+ * ipc_shm_get_chan_stats() - get runtime statistics of a channel
+ * @instance:        instance id
+ * @chan_id:         channel index
+ * @stats:           filled with channel statistics
+ *
+ * Counters are updated without locking, so the result is a snapshot that may
+ * miss operations in progress.
+ * Function is thread-safe.
+ *
+ * Return: 0 on success, error code otherwise
+ */
+int ipc_shm_get_chan_stats(const uint8_t instance, int chan_id,
+		struct ipc_shm_chan_stats *stats);
+
+/**
+ * ipc_shm_get_pool_stats() - get runtime statistics of a buffer pool
+ * @instance:        instance id
+ * @chan_id:         managed channel index
+ * @pool_id:         pool index
+ * @stats:           filled with pool statistics
+ *
+ * Counters are updated without locking, so the result is a snapshot that may
+ * miss operations in progress.
+ * Function is thread-safe.
+ *
+ * Return: 0 on success, error code otherwise
+ */
+int ipc_shm_get_pool_stats(const uint8_t instance, int chan_id, int pool_id,
+		struct ipc_shm_pool_stats *stats);
+
+/**
+ * ipc_shm_reset_chan_stats() - reset runtime statistics of a channel
+ * @instance:        instance id
+ * @chan_id:         channel index
+ *
+ * Channel and pool counters and latency histogram are cleared and pool
+ * low-water marks are set to the number of buffers in pool. Operations running
+ * concurrently on the channel may be counted either before or after the reset.
+ * The latency histogram is cleared under its sequence counter, so it is never
+ * seen partly cleared.
+ * Function is thread-safe for different channels but not for the same channel.
+ *
+ * Return: 0 on success, error code otherwise
+ */
+int ipc_shm_reset_chan_stats(const uint8_t instance, int chan_id);
+
+/**
+ * ipc_shm_get_chan_latency() - get latency histogram of a channel
+ * @instance:        instance id
+ * @chan_id:         channel index
+ * @lat:             filled with channel latency histogram
+ *
+ * Function used only for managed channels configured with
+ * IPC_SHM_CHAN_TIMESTAMP. The histogram is updated by the Rx handler and
+ * copied under a sequence counter, so the result is consistent (count, sum and
+ * buckets cover the same messages) but may miss messages being received.
+ * Function is thread-safe.
+ *
+ * Return: 0 on success, error code otherwise
+ */
+int ipc_shm_get_chan_latency(const uint8_t instance, int chan_id,
+		struct ipc_shm_chan_latency *lat);
+
+/**
+ * ipc_shm_latency_percentile() - estimate a latency percentile from histogram
+ * @lat:             channel latency histogram
+ * @permille:        percentile in tenths of percent (e.g. 500 for p50, 990 for
+ *                   p99, 999 for p99.9)
+ *
+ * The estimate is the upper bound of the bucket where the percentile falls,
+ * limited to the maximum latency measured.
+ * Function is thread-safe.
+ *
+ * Return: latency percentile in counter ticks, 0 if histogram is empty
+ */
+uint64_t ipc_shm_latency_percentile(const struct ipc_shm_chan_latency *lat,
+		uint32_t permille);
+
 /**
  * ipc_shm_is_remote_ready() - check whether remote is initialized
  * @instance:        instance id
@@ -346,4 +931,43 @@ int ipc_shm_is_remote_ready(const uint8_t instance);
  */
 int ipc_shm_poll_channels(const uint8_t instance);
 
+/**
+ * ipc_shm_poll_channel() - poll one channel for available messages to process
+ * @instance:        instance id
+ * @chan_id:         channel index
+ * @budget:          maximum number of messages to process
+ *
+ * Lets a dedicated thread busy-poll its own channel without handling the
+ * other channels. Only available when the instance is configured for polling
+ * (inter_core_rx_irq is IPC_IRQ_NONE). As in ipc_shm_poll_channels(), the
+ * channel is checked once per call with IPC_SHM_INTEGRITY_BACKGROUND policy
+ * and remote doesn't notify messages while it is polled with
+ * IPC_SHM_NOTIFY_SUPPRESS.
+ * Function is thread-safe for different channels but not for the same channel
+ * and must not run concurrently with ipc_shm_poll_channels().
+ *
+ * Return: number of messages processed, -EOPNOTSUPP if Rx interrupt is
+ *         configured, error code otherwise
+ */
+int ipc_shm_poll_channel(const uint8_t instance, int chan_id, int budget);
+
+/**
+ * ipc_shm_poll_channel_mask() - poll selected channels for available messages
+ * @instance:        instance id
+ * @chan_mask:       channel bitmap, bit i of word w selects channel 32w + i
+ * @mask_len:        number of words of chan_mask, from 1 to
+ *                   IPC_SHM_CHAN_MASK_LEN(num_channels)
+ * @budget:          maximum number of messages to process
+ *
+ * Same as ipc_shm_poll_channel() for a set of channels, handled according to
+ * their priority and weight like in ipc_shm_poll_channels(). The mask must
+ * select at least one channel and only configured channels.
+ * Function is thread-safe for disjoint channel masks.
+ *
+ * Return: number of messages processed, -EOPNOTSUPP if Rx interrupt is
+ *         configured, error code otherwise
+ */
+int ipc_shm_poll_channel_mask(const uint8_t instance,
+		const uint32_t chan_mask[], int mask_len, int budget);
+
 #endif /* IPC_SHM_H */
@@ -339,14 +339,32 @@ static void __exit shm_mod_exit(void)
 }
 
 EXPORT_SYMBOL(ipc_shm_init);
+EXPORT_SYMBOL(ipc_shm_arena_size);
 EXPORT_SYMBOL(ipc_shm_free);
 EXPORT_SYMBOL(ipc_shm_acquire_buf);
+EXPORT_SYMBOL(ipc_shm_acquire_bufs);
 EXPORT_SYMBOL(ipc_shm_release_buf);
+EXPORT_SYMBOL(ipc_shm_release_bufs);
 EXPORT_SYMBOL(ipc_shm_tx);
+EXPORT_SYMBOL(ipc_shm_tx_batch);
+EXPORT_SYMBOL(ipc_shm_tx_sg);
+EXPORT_SYMBOL(ipc_shm_tx_large);
+EXPORT_SYMBOL(ipc_shm_chan_pending_rx);
+EXPORT_SYMBOL(ipc_shm_chan_tx_space);
+EXPORT_SYMBOL(ipc_shm_pool_free_bufs);
 EXPORT_SYMBOL(ipc_shm_unmanaged_acquire);
 EXPORT_SYMBOL(ipc_shm_unmanaged_tx);
+EXPORT_SYMBOL(ipc_shm_inline_tx);
+EXPORT_SYMBOL(ipc_shm_check_integrity);
+EXPORT_SYMBOL(ipc_shm_get_chan_stats);
+EXPORT_SYMBOL(ipc_shm_get_pool_stats);
+EXPORT_SYMBOL(ipc_shm_reset_chan_stats);
+EXPORT_SYMBOL(ipc_shm_get_chan_latency);
+EXPORT_SYMBOL(ipc_shm_latency_percentile);
 EXPORT_SYMBOL(ipc_shm_is_remote_ready);
 EXPORT_SYMBOL(ipc_shm_poll_channels);
+EXPORT_SYMBOL(ipc_shm_poll_channel);
+EXPORT_SYMBOL(ipc_shm_poll_channel_mask);
 
 module_init(shm_mod_init);
 module_exit(shm_mod_exit);
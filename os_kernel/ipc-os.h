@@ -6,6 +6,17 @@
 #define IPC_OS_H
 
 #include <linux/module.h>
+#include <asm/barrier.h>
+#include <linux/atomic.h>
+#include <linux/processor.h>
+#include <linux/bottom_half.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#ifdef CONFIG_ARM64
+#include <asm/arch_timer.h>
+#else
+#include <linux/timekeeping.h>
+#endif
 
 #define DRIVER_NAME	"ipc-shm-dev"
 
@@ -20,6 +31,52 @@
 #define shm_err(fmt, ...) pr_err(shm_fmt(fmt), __func__, ##__VA_ARGS__)
 #define shm_dbg(fmt, ...) pr_debug(shm_fmt(fmt), __func__, ##__VA_ARGS__)
 
+/*
+ * memory ordering of shared memory control data (e.g. ring indexes): stores
+ * publish all prior writes and loads are not reordered with later accesses
+ */
+#define ipc_os_load_acquire(p) smp_load_acquire(p)
+#define ipc_os_store_release(p, v) smp_store_release(p, v)
+
+/* full barrier: orders prior stores before later loads */
+#define ipc_os_mb() smp_mb()
+
+/*
+ * lock-free update of local control data shared by threads: compare and swap
+ * returns true if *p was old and has been replaced with new
+ */
+#define ipc_os_cas(p, old, new) (cmpxchg(p, old, new) == (old))
+
+/* allocation of driver private data at init */
+#define ipc_os_mem_alloc(size) kmalloc(size, GFP_KERNEL)
+#define ipc_os_mem_free(p) kfree(p)
+
+/* allocation of large driver buffers at init, may be virtually contiguous */
+#define ipc_os_buf_alloc(size) kvmalloc(size, GFP_KERNEL)
+#define ipc_os_buf_free(p) kvfree(p)
+
+/* busy-wait hint */
+#define ipc_os_cpu_relax() cpu_relax()
+
+/*
+ * queue ticket (and release cache lock) critical section: Rx softirq is kept
+ * off the local CPU from ticket claim to publish, otherwise an Rx callback
+ * using the same channel would spin forever on the ticket of the thread it
+ * interrupted
+ */
+#define ipc_os_ticket_enter() local_bh_disable()
+#define ipc_os_ticket_exit() local_bh_enable()
+
+/*
+ * monotonic counter readable by all cores, used to measure cross-core latency:
+ * ARM generic timer virtual count on ARM64, monotonic clock in ns otherwise
+ */
+#ifdef CONFIG_ARM64
+#define ipc_os_get_timestamp() ((uint64_t)__arch_counter_get_cntvct())
+#else
+#define ipc_os_get_timestamp() ((uint64_t)ktime_get_ns())
+#endif
+
 /* forward declarations */
 struct ipc_shm_cfg;
 
@@ -6,10 +6,15 @@
 #define IPC_OS_H
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <time.h>
 
 /* softirq work budget used to prevent CPU starvation */
 #define IPC_SOFTIRQ_BUDGET 128u
@@ -26,6 +31,68 @@
 #define shm_dbg(fmt, ...)
 #endif
 
+/*
+ * memory ordering of shared memory control data (e.g. ring indexes): stores
+ * publish all prior writes and loads are not reordered with later accesses
+ */
+#define ipc_os_load_acquire(p) \
+	atomic_load_explicit((_Atomic __typeof__(*(p)) *)(p), \
+		memory_order_acquire)
+#define ipc_os_store_release(p, v) \
+	atomic_store_explicit((_Atomic __typeof__(*(p)) *)(p), (v), \
+		memory_order_release)
+
+/* full barrier: orders prior stores before later loads */
+#define ipc_os_mb() atomic_thread_fence(memory_order_seq_cst)
+
+/*
+ * lock-free update of local control data shared by threads: compare and swap
+ * returns true if *p was old and has been replaced with new
+ */
+#define ipc_os_cas(p, old, new) \
+	({ __typeof__(*(p)) __ipc_old = (old); \
+	atomic_compare_exchange_strong_explicit( \
+		(_Atomic __typeof__(*(p)) *)(p), &__ipc_old, (new), \
+		memory_order_acq_rel, memory_order_acquire); })
+
+/* allocation of driver private data at init */
+#define ipc_os_mem_alloc(size) malloc(size)
+#define ipc_os_mem_free(p) free(p)
+
+/* allocation of large driver buffers at init */
+#define ipc_os_buf_alloc(size) malloc(size)
+#define ipc_os_buf_free(p) free(p)
+
+/* busy-wait hint: yield, the awaited thread may run on the same CPU */
+#define ipc_os_cpu_relax() ((void) sched_yield())
+
+/*
+ * queue ticket (and release cache lock) critical section: Rx handler runs in
+ * its own thread, which can't preempt a holder for good, so nothing needs to
+ * be masked
+ */
+#define ipc_os_ticket_enter() do { } while (0)
+#define ipc_os_ticket_exit() do { } while (0)
+
+/*
+ * monotonic counter readable by all cores, used to measure cross-core latency:
+ * ARM generic timer virtual count on AArch64, monotonic clock in ns otherwise
+ */
+static inline uint64_t ipc_os_get_timestamp(void)
+{
+#if defined(__aarch64__)
+	uint64_t cnt;
+
+	__asm__ volatile("isb\n\tmrs %0, cntvct_el0" : "=r" (cnt) : : "memory");
+	return cnt;
+#else
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+#endif
+}
+
 /* forward declarations */
 struct ipc_shm_cfg;
 
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright 2023 NXP
+ */
+
+/*
+ * Host microbenchmark for the BD queue element operations. Each iteration
+ * pushes and pops the same number of 8 byte elements on a local queue (no
+ * shared memory, no remote side), so the figures only compare the relative
+ * cost of the queue code paths on the build host.
+ */
+#include <inttypes.h>
+#include "ipc-os.h"
+#include "ipc-queue.h"
+
+#define BENCH_QUEUE_ELEMS 256u
+#define BENCH_BURST 8
+#define BENCH_DEFAULT_ITERS 50000000L
+
+static uint64_t bench_mem[2 * BENCH_QUEUE_ELEMS + 64]
+	__attribute__((aligned(64)));
+
+/* accumulated popped values, keeps the compiler from dropping the loops */
+static volatile uint64_t bench_sink;
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double bench_generic(struct ipc_queue *queue, long iters)
+{
+	uint64_t in, out, sum = 0;
+	double start = bench_now();
+	long i;
+
+	for (i = 0; i < iters; i++) {
+		in = i;
+		(void)ipc_queue_push(queue, &in);
+		(void)ipc_queue_pop(queue, &out);
+		sum += out;
+	}
+	bench_sink = sum;
+
+	return (bench_now() - start) / iters;
+}
+
+static double bench_64(struct ipc_queue *queue, long iters)
+{
+	uint64_t out, sum = 0;
+	double start = bench_now();
+	long i;
+
+	for (i = 0; i < iters; i++) {
+		(void)ipc_queue_push64(queue, (uint64_t)i);
+		(void)ipc_queue_pop64(queue, &out);
+		sum += out;
+	}
+	bench_sink = sum;
+
+	return (bench_now() - start) / iters;
+}
+
+static double bench_64_n(struct ipc_queue *queue, long iters)
+{
+	uint64_t in[BENCH_BURST], out[BENCH_BURST], sum = 0;
+	double start = bench_now();
+	long i;
+	int j;
+
+	for (i = 0; i < iters; i += BENCH_BURST) {
+		for (j = 0; j < BENCH_BURST; j++)
+			in[j] = i + j;
+		(void)ipc_queue_push64_n(queue, in, BENCH_BURST);
+		(void)ipc_queue_pop64_n(queue, out, BENCH_BURST);
+		for (j = 0; j < BENCH_BURST; j++)
+			sum += out[j];
+	}
+	bench_sink = sum;
+
+	return (bench_now() - start) / iters;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct {
+		const char *name;
+		uint8_t flags;
+	} layouts[] = {
+		{ "legacy", 0 },
+		{ "pow2", IPC_QUEUE_POW2 },
+		{ "pow2+padded", IPC_QUEUE_POW2 | IPC_QUEUE_PADDED },
+	};
+	struct ipc_queue queue;
+	long iters = BENCH_DEFAULT_ITERS;
+	size_t i;
+
+	if (argc > 1)
+		iters = strtol(argv[1], NULL, 0);
+	if (iters < BENCH_BURST) {
+		fprintf(stderr, "usage: %s [iterations >= %d]\n", argv[0],
+			BENCH_BURST);
+		return 1;
+	}
+
+	printf("%-12s %12s %12s %12s  (ns per element, %ld iterations)\n",
+		"layout", "push/pop", "push64/pop64", "64_n burst", iters);
+	for (i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+		double generic, single, burst;
+
+		if (ipc_queue_init(&queue, BENCH_QUEUE_ELEMS, sizeof(uint64_t),
+				layouts[i].flags, (uintptr_t)bench_mem,
+				(uintptr_t)bench_mem) != 0) {
+			fprintf(stderr, "queue init failed for %s\n",
+				layouts[i].name);
+			return 1;
+		}
+
+		generic = bench_generic(&queue, iters);
+		single = bench_64(&queue, iters);
+		burst = bench_64_n(&queue, iters);
+
+		printf("%-12s %12.2f %12.2f %12.2f\n", layouts[i].name,
+			generic, single, burst);
+	}
+
+	return 0;
+}